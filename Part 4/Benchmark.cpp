@@ -0,0 +1,760 @@
+//
+// Benchmark.cpp
+//
+// Micro benchmarks of the game engine (make bench)
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "BoardSymmetry.h"
+#include "GameBatch.h"
+#include "GameController.h"
+#include "GameData.h"
+#include "GameHint.h"
+#include "GameSnapshot.h"
+#include "GameTelemetry.h"
+#include "Helpers.h"
+
+#define BENCH_BOARDS 1000 // boards per measurement
+#define BENCH_ROUNDS 20   // measurements per board type, the best one is reported
+
+namespace {
+
+    struct BenchBoard {
+        std::vector<int> holes;
+        int              click; // a zero cell to reveal
+    };
+
+    // Reproducible black hole layouts with about 15% of holes, each with a cell that opens an area
+    std::vector<BenchBoard> make_bench_boards(int n, unsigned int seed) {
+        std::mt19937 rgen(seed);
+        std::vector<int> cells(n * n);
+        std::vector<BenchBoard> result;
+        while ((int)result.size() < BENCH_BOARDS) {
+            std::iota(cells.begin(), cells.end(), 0);
+            std::shuffle(cells.begin(), cells.end(), rgen);
+            BenchBoard bb;
+            bb.holes.assign(cells.begin(), cells.begin() + std::max(MIN_BLACK_HOLES, n * n * 15 / 100));
+            DynamicGameBoard board(n);
+            board.setup(n, bb.holes);
+            bb.click = -1;
+            for (int i = 0; i < n * n && bb.click < 0; i++) {
+                if (!board.is_black_hole_cell(i / n, i % n) && 0 == board.black_holes_nearby(i / n, i % n)) {
+                    bb.click = i;
+                }
+            }
+            if (bb.click >= 0) {
+                result.push_back(bb);
+            }
+        }
+        return result;
+    }
+
+    double elapsed_ns(std::chrono::steady_clock::time_point start) {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Best of BENCH_ROUNDS, nanoseconds per board
+    template <class Board>
+    void bench_board(int n, const std::vector<BenchBoard>& bench, double& setup_ns, double& open_ns) {
+        std::vector<Board> boards(bench.size(), Board(n));
+        setup_ns = open_ns = 1e30;
+        int checksum = 0;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench.size(); i++) {
+                boards[i].setup(n, bench[i].holes);
+            }
+            setup_ns = std::min(setup_ns, elapsed_ns(start) / bench.size());
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench.size(); i++) {
+                boards[i].do_open(bench[i].click / n, bench[i].click % n);
+            }
+            open_ns = std::min(open_ns, elapsed_ns(start) / bench.size());
+            for (auto& board : boards) {
+                checksum += board.hidden_cells();
+            }
+        }
+        if (checksum < 0) { // keeps the work observable
+            std::printf("%d\n", checksum);
+        }
+    }
+
+    template <int N>
+    void bench_fixed_vs_dynamic() {
+        auto bench = make_bench_boards(N, 2024 + N);
+        double dyn_setup, dyn_open, fix_setup, fix_open;
+        bench_board<DynamicGameBoard>(N, bench, dyn_setup, dyn_open);
+        bench_board<FixedGameBoard<N>>(N, bench, fix_setup, fix_open);
+        std::printf("%5d %12.1f %12.1f %8.2fx %12.1f %12.1f %8.2fx\n", N,
+            dyn_setup, fix_setup, dyn_setup / fix_setup,
+            dyn_open, fix_open, dyn_open / fix_open);
+        if constexpr (N < MAX_BOARD_SIZE) {
+            bench_fixed_vs_dynamic<N + 1>();
+        }
+    }
+
+    // Games in progress: the area of the click and a few more cells opened.
+    // Each game is also evicted to the temporary directory and resumed, the file must be gone after the resume.
+    void bench_snapshot(int n) {
+        const auto bench = make_bench_boards(n, 5151 + n);
+        std::vector<std::unique_ptr<GameBoard>> boards;
+        for (const auto& bb : bench) {
+            boards.push_back(make_game_board(n));
+            boards.back()->setup(n, bb.holes);
+            boards.back()->do_open(bb.click / n, bb.click % n);
+            for (int cell = 0; cell < n * n; cell += 7) {
+                if (!boards.back()->is_black_hole_cell(cell / n, cell % n) && !boards.back()->is_opened_cell(cell / n, cell % n)) {
+                    boards.back()->do_open(cell / n, cell % n);
+                }
+            }
+        }
+        std::vector<std::vector<uint64_t>> snapshots(bench.size());
+        std::vector<std::unique_ptr<GameBoard>> restored(bench.size());
+        double save_ns = 1e30, load_ns = 1e30;
+        bool same = true;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench.size(); i++) {
+                GameSnapshot::save(*boards[i], snapshots[i]);
+            }
+            save_ns = std::min(save_ns, elapsed_ns(start) / bench.size());
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench.size(); i++) {
+                int black_holes = 0;
+                restored[i] = GameSnapshot::load(snapshots[i].data(), snapshots[i].size(), black_holes);
+            }
+            load_ns = std::min(load_ns, elapsed_ns(start) / bench.size());
+            for (size_t i = 0; i < bench.size(); i++) {
+                same = same && restored[i] && restored[i]->visible_hash() == boards[i]->visible_hash() &&
+                       restored[i]->hidden_cells() == boards[i]->hidden_cells();
+            }
+        }
+
+        const std::string spill = std::filesystem::temp_directory_path().string();
+        const uint64_t session = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count() << 16;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < bench.size(); i++) {
+            int black_holes = 0;
+            same = same && GameSnapshot::evict(spill, session + i, *boards[i]);
+            restored[i] = GameSnapshot::resume(spill, session + i, black_holes);
+            same = same && restored[i] && restored[i]->visible_hash() == boards[i]->visible_hash() &&
+                   black_holes == (int)bench[i].holes.size() && !GameSnapshot::resume(spill, session + i, black_holes);
+        }
+        const double spill_ns = elapsed_ns(start) / bench.size();
+        std::printf("%5d %12zu %12.1f %12.1f %12.1f %s\n", n, snapshots[0].size() * sizeof(uint64_t), save_ns, load_ns, spill_ns,
+            same ? "same" : "DIFFERENT");
+    }
+
+    // A bot that knows all the safe cells of the board: one DoMove per cell vs one apply_moves for all of them
+    void bench_moves(int n) {
+        const auto bench = make_bench_boards(n, 4242 + n);
+        std::mt19937 rgen(n);
+        std::vector<std::vector<std::pair<int, int>>> moves(bench.size());
+        for (size_t i = 0; i < bench.size(); i++) {
+            std::vector<char> hole(n * n, 0);
+            for (auto h : bench[i].holes) {
+                hole[h] = 1;
+            }
+            for (int cell = 0; cell < n * n; cell++) {
+                if (!hole[cell]) {
+                    moves[i].emplace_back(cell / n, cell % n);
+                }
+            }
+            std::shuffle(moves[i].begin(), moves[i].end(), rgen);
+        }
+
+        std::vector<std::unique_ptr<GameBoard>> single, batch;
+        for (size_t i = 0; i < bench.size(); i++) {
+            single.push_back(make_game_board(n));
+            batch.push_back(make_game_board(n));
+        }
+        double single_ns = 1e30, batch_ns = 1e30;
+        bool same = true;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (size_t i = 0; i < bench.size(); i++) {
+                single[i]->setup(n, bench[i].holes);
+                batch[i]->setup(n, bench[i].holes);
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench.size(); i++) {
+                for (const auto& cell : moves[i]) {
+                    if (MoveResult::Win == DoMove(*single[i], cell.first, cell.second)) {
+                        break;
+                    }
+                }
+            }
+            single_ns = std::min(single_ns, elapsed_ns(start) / bench.size());
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench.size(); i++) {
+                batch[i]->apply_moves(moves[i]);
+            }
+            batch_ns = std::min(batch_ns, elapsed_ns(start) / bench.size());
+            for (size_t i = 0; i < bench.size(); i++) {
+                same = same && single[i]->IsWin() && batch[i]->IsWin() && single[i]->visible_hash() == batch[i]->visible_hash();
+            }
+        }
+        std::printf("%5d %12zu %12.1f %12.1f %8.2fx %s\n", n, moves[0].size(), single_ns, batch_ns, single_ns / batch_ns,
+            same ? "same" : "DIFFERENT");
+    }
+
+    // Keeps a copy of the visible board, as the UI or a bot would
+    struct VisibleCopy : BoardObserver {
+        std::vector<signed char> cells;
+
+        void on_move(const GameBoard& board, const BoardDelta& delta) override {
+            const int n = board.board_size();
+            for (auto i = 0; i < delta.opened_count; i++) {
+                cells[delta.opened[i]] = (signed char)board.black_holes_nearby(delta.opened[i] / n, delta.opened[i] % n);
+            }
+            for (auto i = 0; i < delta.hole_count; i++) {
+                cells[delta.holes[i]] = 9;
+            }
+        }
+
+        void rescan(const GameBoard& board) {
+            const int n = board.board_size();
+            for (auto row = 0; row < n; row++) {
+                for (auto col = 0; col < n; col++) {
+                    cells[row * n + col] = !board.is_opened_cell(row, col) ? -1
+                                         : board.is_black_hole_cell(row, col) ? 9 : (signed char)board.black_holes_nearby(row, col);
+                }
+            }
+        }
+    };
+
+    // The copy of the visible board kept up to date after every move of a game: a rescan of the board vs the deltas
+    void bench_observer(int n) {
+        const auto bench = make_bench_boards(n, 7171 + n);
+        std::mt19937 rgen(n);
+        std::vector<std::vector<std::pair<int, int>>> moves(bench.size());
+        for (size_t i = 0; i < bench.size(); i++) {
+            for (int cell = 0; cell < n * n; cell++) {
+                moves[i].emplace_back(cell / n, cell % n);
+            }
+            std::shuffle(moves[i].begin(), moves[i].end(), rgen);
+        }
+        std::vector<std::unique_ptr<GameBoard>> boards;
+        std::vector<VisibleCopy> copies(bench.size());
+        for (size_t i = 0; i < bench.size(); i++) {
+            boards.push_back(make_game_board(n));
+        }
+        VisibleCopy rescanned;
+        rescanned.cells.assign(n * n, -1);
+        double rescan_ns = 1e30, delta_ns = 1e30;
+        bool same = true;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            for (int observe = 0; observe < 2; observe++) {
+                for (size_t i = 0; i < bench.size(); i++) {
+                    boards[i]->setup(n, bench[i].holes);
+                    copies[i].cells.assign(n * n, -1);
+                    if (observe) {
+                        boards[i]->subscribe(&copies[i]);
+                    }
+                }
+                size_t count = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < bench.size(); i++) {
+                    for (size_t k = 0; k < moves[i].size() && !boards[i]->IsGameover(); k++) {
+                        count++;
+                        DoMove(*boards[i], moves[i][k].first, moves[i][k].second);
+                        if (!observe) {
+                            rescanned.rescan(*boards[i]);
+                        }
+                    }
+                }
+                double& best = observe ? delta_ns : rescan_ns;
+                best = std::min(best, elapsed_ns(start) / count);
+                if (observe) {
+                    for (size_t i = 0; i < bench.size(); i++) {
+                        boards[i]->unsubscribe(&copies[i]);
+                        rescanned.rescan(*boards[i]);
+                        same = same && rescanned.cells == copies[i].cells;
+                    }
+                }
+            }
+        }
+        std::printf("%5d %12.1f %12.1f %8.2fx %s\n", n, rescan_ns, delta_ns, rescan_ns / delta_ns, same ? "same" : "DIFFERENT");
+    }
+
+    // The cost of the telemetry on the move path: the threads play all safe cells of their boards with DoMove,
+    // with the telemetry off and on (the drop policy, into /dev/null)
+    void bench_telemetry(int n, int threads) {
+        const auto bench = make_bench_boards(n, 6161 + n);
+        std::vector<std::vector<std::pair<int, int>>> moves(bench.size());
+        for (size_t i = 0; i < bench.size(); i++) {
+            std::vector<char> hole(n * n, 0);
+            for (auto h : bench[i].holes) {
+                hole[h] = 1;
+            }
+            for (int cell = 0; cell < n * n; cell++) {
+                if (!hole[cell]) {
+                    moves[i].emplace_back(cell / n, cell % n);
+                }
+            }
+        }
+        // Best of BENCH_ROUNDS, ns per move of a thread
+        auto measure = [&]() {
+            std::vector<double> thread_ns(threads, 1e30);
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++) {
+                workers.emplace_back([&, t]() {
+                    std::vector<std::unique_ptr<GameBoard>> boards;
+                    for (size_t i = 0; i < bench.size(); i++) {
+                        boards.push_back(make_game_board(n));
+                    }
+                    for (int round = 0; round < BENCH_ROUNDS; round++) {
+                        for (size_t i = 0; i < bench.size(); i++) {
+                            boards[i]->setup(n, bench[i].holes);
+                        }
+                        size_t count = 0;
+                        auto start = std::chrono::steady_clock::now();
+                        for (size_t i = 0; i < bench.size(); i++) {
+                            for (const auto& cell : moves[i]) {
+                                count++;
+                                if (MoveResult::Win == DoMove(*boards[i], cell.first, cell.second)) {
+                                    break;
+                                }
+                            }
+                        }
+                        thread_ns[t] = std::min(thread_ns[t], elapsed_ns(start) / count);
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            return std::accumulate(thread_ns.begin(), thread_ns.end(), 0.0) / threads;
+        };
+        const double off_ns = measure();
+        if (!GameTelemetry::start("/dev/null", GameTelemetry::Format::Binary, GameTelemetry::Overflow::Drop)) {
+            std::printf("%5d %8d telemetry cannot start\n", n, threads);
+            return;
+        }
+        const double on_ns = measure();
+        const uint64_t dropped = GameTelemetry::dropped();
+        GameTelemetry::stop();
+        std::printf("%5d %8d %12.1f %12.1f %12.1f %12llu\n", n, threads, off_ns, on_ns, on_ns - off_ns, (unsigned long long)dropped);
+    }
+
+    // The sampling of the hole probabilities against the exact enumeration, on positions small enough to count:
+    // the area of the click and a few more cells opened. The sampling is forced by an enumeration budget of one step.
+    // Each probability has a 95% confidence interval, so about 1 cell in 20 may miss it, and the cells of a position
+    // miss together: the results are DIFFERENT if fewer than 85% of the cells are within their interval,
+    // or any cell is off by more than 3 of them.
+    void bench_estimate(int n, int positions, int sample_ms) {
+        const auto bench = make_bench_boards(n, 7171 + n);
+        const std::atomic<bool> cancelled{ false };
+        GameHint::EstimateLimits sampling;
+        sampling.exact_nodes = 1;
+        sampling.sample_ms = sample_ms;
+        int counted = 0, cells = 0, within = 0;
+        double worst = 0, exact_ms = 0, sample_ms_total = 0;
+        bool same = true;
+        for (size_t i = 0; i < bench.size() && counted < positions; i++) {
+            DynamicGameBoard board(n);
+            board.setup(n, bench[i].holes);
+            board.do_open(bench[i].click / n, bench[i].click % n);
+            for (int cell = 0; cell < n * n; cell += 11) {
+                if (!board.is_black_hole_cell(cell / n, cell % n) && !board.is_opened_cell(cell / n, cell % n)) {
+                    board.do_open(cell / n, cell % n);
+                }
+            }
+            const GameHint::BoardView view = GameHint::snapshot(board, (int)bench[i].holes.size());
+            GameHint::Estimate exact, sampled;
+            auto start = std::chrono::steady_clock::now();
+            if (!GameHint::estimate(view, {}, cancelled, GameHint::EstimateLimits(), exact) || !exact.exact) {
+                continue; // Too large to count
+            }
+            exact_ms += elapsed_ns(start) / 1e6;
+            start = std::chrono::steady_clock::now();
+            if (!GameHint::estimate(view, {}, cancelled, sampling, sampled)) {
+                same = false;
+                continue;
+            }
+            sample_ms_total += elapsed_ns(start) / 1e6;
+            counted++;
+            for (int c = 0; c < n * n; c++) {
+                if (exact.probability[c] < 0) {
+                    continue;
+                }
+                const double off = std::abs(sampled.probability[c] - exact.probability[c]);
+                cells++;
+                within += off <= sampled.error[c] + 1e-9;
+                worst = std::max(worst, off / std::max(sampled.error[c], 1e-9));
+                same = same && off <= 3 * sampled.error[c] + 1e-9;
+            }
+        }
+        same = same && counted > 0 && within >= 0.85 * cells;
+        std::printf("%5d %10d %8d %12.2f %12.2f %9.1f%% %12.2f %s\n", n, counted, cells, exact_ms / std::max(counted, 1),
+            sample_ms_total / std::max(counted, 1), 100.0 * within / std::max(cells, 1), worst, same ? "same" : "DIFFERENT");
+    }
+
+    // Canonical orientation of random boards made by randoms(): the bit tricks on the packed hole mask
+    // vs the comparison of the 8 transforms of the cell grid, and the share of the corpus left by the deduplication
+    void bench_symmetry(int n, int holes, int boards) {
+        std::vector<std::vector<int>> corpus;
+        for (int i = 0; i < boards; i++) {
+            corpus.push_back(randoms(holes, 0, n * n - 1));
+        }
+
+        std::vector<BoardSymmetry::HoleMask> masks(corpus.size());
+        std::vector<std::vector<char>> grids(corpus.size(), std::vector<char>(n * n, 0));
+        for (size_t i = 0; i < corpus.size(); i++) {
+            masks[i] = BoardSymmetry::pack(n, corpus[i]);
+            for (auto h : corpus[i]) {
+                grids[i][h] = 1;
+            }
+        }
+
+        double mask_ns = 1e30, grid_ns = 1e30;
+        std::vector<BoardSymmetry::HoleMask> canonical(corpus.size());
+        std::vector<std::vector<char>> canonical_grids(corpus.size());
+        for (int round = 0; round < 5; round++) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < corpus.size(); i++) {
+                BoardSymmetry::canonicalize(masks[i], canonical[i]);
+            }
+            mask_ns = std::min(mask_ns, elapsed_ns(start) / corpus.size());
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < corpus.size(); i++) {
+                BoardSymmetry::canonicalize(n, grids[i], canonical_grids[i]);
+            }
+            grid_ns = std::min(grid_ns, elapsed_ns(start) / corpus.size());
+        }
+
+        // The two orders of the orientations differ, but both must pick an orientation of the same board
+        bool same = true;
+        for (size_t i = 0; i < corpus.size() && same; i++) {
+            std::vector<int> holes;
+            for (int c = 0; c < n * n; c++) {
+                if (canonical_grids[i][c]) {
+                    holes.push_back(c);
+                }
+            }
+            BoardSymmetry::HoleMask mask;
+            BoardSymmetry::canonicalize(BoardSymmetry::pack(n, holes), mask);
+            same = mask == canonical[i];
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        const size_t removed = BoardSymmetry::deduplicate(n, corpus);
+        const double dedup_ns = elapsed_ns(start) / boards;
+        std::printf("%5d %6d %12.1f %12.1f %8.2fx %12.1f %8d %8d %s\n", n, holes, grid_ns, mask_ns, grid_ns / mask_ns,
+            dedup_ns, boards, (int)(boards - removed), same ? "same" : "DIFFERENT");
+    }
+
+    // The board metrics of one storage and topology checked two ways: the openings against the region index
+    // (square boards only, the other topologies have none) and 3BV against the clicks that clear the board,
+    // one into every closed zero cell and one on every safe cell left closed.
+    void bench_metrics(const char* storage, const char* name, int n, BoardTopology topology, bool tiled) {
+        const auto bench = make_bench_boards(n, 8181 + n);
+        const bool indexed = BoardTopology::Square == topology;
+        GameSettings::getSettings().set_tiled_layout(tiled);
+        GameSettings::getSettings().set_region_index(indexed);
+        auto board = make_game_board(n, topology);
+
+        bool same = true;
+        double bbbv = 0, metrics_ns = 0;
+        for (const auto& bb : bench) {
+            board->setup(n, bb.holes);
+            auto start = std::chrono::steady_clock::now();
+            const BoardMetrics metrics = board->metrics();
+            metrics_ns += elapsed_ns(start);
+            bbbv += metrics.bbbv;
+            same = same && (!indexed || metrics.openings == board->zero_regions());
+
+            int clicks = 0;
+            for (int i = 0; i < n * n; i++) {
+                if (!board->is_opened_cell(i / n, i % n) && !board->is_black_hole_cell(i / n, i % n)
+                    && 0 == board->black_holes_nearby(i / n, i % n)) {
+                    board->do_open(i / n, i % n);
+                    clicks++;
+                }
+            }
+            same = same && clicks == metrics.openings && clicks + board->hidden_cells() == metrics.bbbv;
+        }
+        GameSettings::getSettings().set_region_index(false);
+        GameSettings::getSettings().set_tiled_layout(false);
+        std::printf("%5d %10s %12s %10.1f %12.1f %s\n", n, storage, name, bbbv / bench.size(),
+            metrics_ns / bench.size(), same ? "same" : "DIFFERENT");
+    }
+
+    // Reveal of a large area: the serial fill (one thread), the parallel one (all hardware threads)
+    // and the lookup in the region index (its build time is reported separately).
+    // The black holes take about 5% of the board, so one click opens most of it.
+    void bench_large_reveal(int n) {
+        std::mt19937 rgen(2024 + n);
+        std::vector<int> holes;
+        std::bernoulli_distribution is_hole(0.05);
+        for (int i = 0; i < n * n; i++) {
+            if (is_hole(rgen)) {
+                holes.push_back(i);
+            }
+        }
+        DynamicGameBoard serial(n), parallel(n), indexed(n);
+        serial.setup(n, holes);
+        int click = n * n / 2;
+        while (serial.is_black_hole_cell(click / n, click % n) || serial.black_holes_nearby(click / n, click % n)) {
+            click++;
+        }
+
+        double serial_ns = 1e30, parallel_ns = 1e30, index_ns = 1e30, lookup_ns = 1e30;
+        for (int round = 0; round < 3; round++) {
+            serial.setup(n, holes);
+            parallel.setup(n, holes);
+
+            GameSettings::getSettings().set_region_index(true);
+            auto start = std::chrono::steady_clock::now();
+            indexed.setup(n, holes);
+            index_ns = std::min(index_ns, elapsed_ns(start));
+            GameSettings::getSettings().set_region_index(false);
+            start = std::chrono::steady_clock::now();
+            indexed.do_open(click / n, click % n);
+            lookup_ns = std::min(lookup_ns, elapsed_ns(start));
+
+            GameSettings::getSettings().set_open_threads(1);
+            start = std::chrono::steady_clock::now();
+            serial.do_open(click / n, click % n);
+            serial_ns = std::min(serial_ns, elapsed_ns(start));
+
+            GameSettings::getSettings().set_open_threads(0);
+            start = std::chrono::steady_clock::now();
+            parallel.do_open(click / n, click % n);
+            parallel_ns = std::min(parallel_ns, elapsed_ns(start));
+        }
+
+        bool same = true;
+        for (int row = 0; row < n && same; row++) {
+            for (int col = 0; col < n && same; col++) {
+                same = (serial.is_opened_cell(row, col) == parallel.is_opened_cell(row, col)
+                     && serial.is_opened_cell(row, col) == indexed.is_opened_cell(row, col));
+            }
+        }
+        std::printf("%5d %12d %12.2f %12.2f %8.2fx %12.2f %12.2f %s\n", n, n * n - serial.hidden_cells() - (int)holes.size(),
+            serial_ns / 1e6, parallel_ns / 1e6, serial_ns / parallel_ns, lookup_ns / 1e6, index_ns / 1e6, same ? "same" : "DIFFERENT");
+    }
+
+    // Setup and reveal of a large area on one board layout, milliseconds. The reveal is serial to compare the layouts only.
+    // Returns a checksum of the opened cells to compare the layouts.
+    template <class Board>
+    uint64_t bench_layout(int n, const std::vector<int>& holes, int click, int reps, double& setup_ms, double& open_ms) {
+        GameSettings::getSettings().set_open_threads(1);
+        Board board(n);
+        setup_ms = open_ms = 1e30;
+        for (int round = 0; round < reps; round++) {
+            auto start = std::chrono::steady_clock::now();
+            board.setup(n, holes);
+            setup_ms = std::min(setup_ms, elapsed_ns(start) / 1e6);
+            start = std::chrono::steady_clock::now();
+            board.do_open(click / n, click % n);
+            open_ms = std::min(open_ms, elapsed_ns(start) / 1e6);
+        }
+        GameSettings::getSettings().set_open_threads(0);
+        uint64_t checksum = 0;
+        for (int row = 0; row < n; row++) {
+            for (int col = 0; col < n; col++) {
+                if (board.is_opened_cell(row, col)) {
+                    checksum = checksum * 31 + (uint64_t)row * n + col;
+                }
+            }
+        }
+        return checksum;
+    }
+
+    void bench_row_major_vs_tiled(int n) {
+        std::mt19937 rgen(2024 + n);
+        std::vector<int> holes;
+        std::bernoulli_distribution is_hole(0.05);
+        for (int i = 0; i < n * n; i++) {
+            if (is_hole(rgen)) {
+                holes.push_back(i);
+            }
+        }
+        // The clicked cell is the first zero cell from the center, checked against the hole list only
+        std::vector<bool> hole(n * n, false);
+        for (auto i : holes) {
+            hole[i] = true;
+        }
+        int click = n * n / 2 - 1;
+        bool zero = false;
+        while (!zero && ++click < n * n) {
+            zero = true;
+            for (const auto& d : compass_rose) {
+                const int r = click / n + d[1], c = click % n + d[0];
+                zero = zero && !(r >= 0 && c >= 0 && r < n && c < n && hole[r * n + c]);
+            }
+            zero = zero && !hole[click];
+        }
+        const int reps = std::max(3, (1 << 20) / (n * n));
+        double rm_setup, rm_open, tiled_setup, tiled_open;
+        const uint64_t rm = bench_layout<DynamicGameBoard>(n, holes, click, reps, rm_setup, rm_open);
+        const uint64_t tiled = bench_layout<TiledGameBoard>(n, holes, click, reps, tiled_setup, tiled_open);
+        std::printf("%5d %12.3f %12.3f %8.2fx %12.3f %12.3f %8.2fx %s\n", n,
+            rm_setup, tiled_setup, rm_setup / tiled_setup, rm_open, tiled_open, rm_open / tiled_open,
+            rm == tiled ? "same" : "DIFFERENT");
+    }
+
+    // Games of BoardBatch<N> against the scalar FixedGameBoard<N>, with the same boards and the same moves.
+    // The moves are recorded by a scalar run of a player who mostly opens a cell without a black hole.
+    template <int N>
+    void bench_batch(int batches) {
+        const int games = batches * BATCH_LANES, steps = N * N;
+        std::mt19937 rgen(4242 + N);
+        std::vector<int> cells(N * N);
+        std::vector<std::vector<int>> holes(games);
+        std::vector<int> rows(games * steps, -1), cols(games * steps, -1);
+        std::vector<MoveResult> expected(games * steps, MoveResult::Invalid);
+        std::vector<int> expected_hidden(games);
+        for (int g = 0; g < games; g++) {
+            std::iota(cells.begin(), cells.end(), 0);
+            std::shuffle(cells.begin(), cells.end(), rgen);
+            holes[g].assign(cells.begin(), cells.begin() + std::max(MIN_BLACK_HOLES, N * N * 15 / 100));
+            FixedGameBoard<N> board;
+            board.setup(N, holes[g]);
+            for (int step = 0; step < steps && !board.IsGameover(); step++) {
+                int cell = rgen() % (N * N);
+                for (int tries = 0; tries < N * N && rgen() % 50 && board.is_black_hole_cell(cell / N, cell % N); tries++) {
+                    cell = rgen() % (N * N);
+                }
+                rows[g * steps + step] = cell / N;
+                cols[g * steps + step] = cell % N;
+                expected[g * steps + step] = DoMove(board, cell / N, cell % N);
+            }
+            expected_hidden[g] = board.hidden_cells();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int checksum = 0;
+        for (int g = 0; g < games; g++) {
+            FixedGameBoard<N> board;
+            board.setup(N, holes[g]);
+            for (int step = 0; step < steps && rows[g * steps + step] >= 0; step++) {
+                checksum += (int)DoMove(board, rows[g * steps + step], cols[g * steps + step]);
+            }
+        }
+        const double scalar_ns = elapsed_ns(start) / games;
+
+        bool same = true;
+        BoardBatch<N> batch;
+        start = std::chrono::steady_clock::now();
+        for (int b = 0; b < batches; b++) {
+            batch.setup(std::vector<std::vector<int>>(holes.begin() + b * BATCH_LANES, holes.begin() + (b + 1) * BATCH_LANES));
+            int lane_rows[BATCH_LANES], lane_cols[BATCH_LANES];
+            MoveResult results[BATCH_LANES];
+            for (int step = 0; step < steps; step++) {
+                bool any = false;
+                for (int lane = 0; lane < BATCH_LANES; lane++) {
+                    const int g = b * BATCH_LANES + lane;
+                    lane_rows[lane] = rows[g * steps + step];
+                    lane_cols[lane] = cols[g * steps + step];
+                    any = any || lane_rows[lane] >= 0;
+                }
+                if (!any) {
+                    break;
+                }
+                batch.move(lane_rows, lane_cols, results);
+                for (int lane = 0; lane < BATCH_LANES; lane++) {
+                    const int g = b * BATCH_LANES + lane;
+                    same = same && (lane_rows[lane] < 0 || results[lane] == expected[g * steps + step]);
+                }
+            }
+            for (int lane = 0; lane < BATCH_LANES; lane++) {
+                same = same && batch.hidden_cells(lane) == expected_hidden[b * BATCH_LANES + lane];
+            }
+        }
+        const double batch_ns = elapsed_ns(start) / games;
+        if (checksum < 0) { // keeps the work observable
+            std::printf("%d\n", checksum);
+        }
+        std::printf("%5d %12.1f %12.1f %8.2fx %s\n", N, scalar_ns, batch_ns, scalar_ns / batch_ns, same ? "same" : "DIFFERENT");
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // The largest board of the layout comparison, e.g. 16384 (needs about 2 GB of memory per board)
+    const int max_layout_size = (argc > 1) ? std::atoi(argv[1]) : 4096;
+
+    std::printf("DynamicGameBoard vs FixedGameBoard<N>, ns per board\n");
+    std::printf("%5s %12s %12s %9s %12s %12s %9s\n", "size", "setup dyn", "setup fixed", "gain", "open dyn", "open fixed", "gain");
+    bench_fixed_vs_dynamic<MIN_BOARD_SIZE>();
+
+    std::printf("\nScalar FixedGameBoard<N> vs BoardBatch<N> (%d lanes), ns per game\n", BATCH_LANES);
+    std::printf("%5s %12s %12s %9s %s\n", "size", "scalar", "batch", "gain", "results");
+    bench_batch<5>(64);
+    bench_batch<8>(64);
+    bench_batch<12>(64);
+    bench_batch<16>(64);
+
+    std::printf("\nAll safe cells of a board, one move at a time vs one batch, ns per board\n");
+    std::printf("%5s %12s %12s %12s %9s %s\n", "size", "moves", "single", "batch", "gain", "results");
+    bench_moves(8);
+    bench_moves(16);
+    bench_moves(64);
+
+    std::printf("\nSnapshot of a game in progress, save vs restore vs evict and resume through a file, ns per game\n");
+    std::printf("%5s %12s %12s %12s %12s %s\n", "size", "bytes", "save", "restore", "evict+resume", "results");
+    bench_snapshot(8);
+    bench_snapshot(16);
+    bench_snapshot(64);
+
+    std::printf("\nA copy of the visible board after every move, rescan vs observer deltas, ns per move\n");
+    std::printf("%5s %12s %12s %9s %s\n", "size", "rescan", "deltas", "gain", "results");
+    bench_observer(8);
+    bench_observer(16);
+    bench_observer(64);
+
+    std::printf("\nTelemetry of the moves, off vs on, ns per move of a thread\n");
+    std::printf("%5s %8s %12s %12s %12s %12s\n", "size", "threads", "off", "on", "cost", "dropped");
+    const int hardware_threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    bench_telemetry(16, 1);
+    bench_telemetry(16, hardware_threads);
+    bench_telemetry(64, hardware_threads);
+
+    std::printf("\nHole probabilities sampled vs counted exactly, ms per position\n");
+    std::printf("%5s %10s %8s %12s %12s %10s %12s %s\n", "size", "positions", "cells", "exact", "sampled", "within CI", "worst/CI", "results");
+    bench_estimate(8, 20, 40);
+    bench_estimate(12, 20, 40);
+
+    std::printf("\nBoard metrics vs region index and clicks, ns per board\n");
+    std::printf("%5s %10s %12s %10s %12s %s\n", "size", "storage", "topology", "3BV", "metrics", "results");
+    bench_metrics("fixed", "square", 16, BoardTopology::Square, false);
+    bench_metrics("dynamic", "square", 64, BoardTopology::Square, false);
+    bench_metrics("tiled", "square", 64, BoardTopology::Square, true);
+    bench_metrics("dynamic", "von-neumann", 32, BoardTopology::VonNeumann, false);
+    bench_metrics("dynamic", "hex", 32, BoardTopology::Hex, false);
+    bench_metrics("dynamic", "torus", 32, BoardTopology::Torus, false);
+
+    std::printf("\nCanonical orientation of random boards, cell grid vs packed hole mask, ns per board\n");
+    std::printf("%5s %6s %12s %12s %9s %12s %8s %8s %s\n", "size", "holes", "grid", "mask", "gain", "dedup", "boards", "unique", "results");
+    bench_symmetry(5, 2, 20000);
+    bench_symmetry(5, 4, 20000);
+    bench_symmetry(8, 10, 20000);
+    bench_symmetry(16, 40, 20000);
+
+    std::printf("\nLarge area reveal, serial vs parallel fill vs region index lookup, ms per click\n");
+    std::printf("%5s %12s %12s %12s %9s %12s %12s %s\n", "size", "opened", "serial", "parallel", "gain", "lookup", "index setup", "opened cells");
+    for (int n : { 512, 1024, 2048, 4096 }) {
+        bench_large_reveal(n);
+    }
+
+    std::printf("\nRow-major vs tiled (Z-order) layout, ms per board\n");
+    std::printf("%5s %12s %12s %9s %12s %12s %9s %s\n", "size", "setup rm", "setup tiled", "gain", "open rm", "open tiled", "gain", "opened cells");
+    for (int n = 16; n <= max_layout_size; n *= 4) {
+        bench_row_major_vs_tiled(n);
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+//
+// BoardPool.cpp
+//
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "BoardPool.h"
+#include "GameData.h"
+#include "Helpers.h"
+
+#define BOARD_POOL_SIZE 4 // ready boards kept in the pool
+
+namespace BoardPool {
+
+    namespace {
+
+        // The settings a board is made for
+        uint64_t settings_key(int board_size, int black_holes) {
+            return ((uint64_t)(uint32_t)board_size << 32) | (uint32_t)black_holes;
+        }
+
+        uint64_t current_settings_key() {
+            return settings_key(GameSettings::getSettings().get_board_size(), GameSettings::getSettings().get_black_holes());
+        }
+
+        struct Slot {
+            GameBoard* board;
+            uint64_t   key;
+        };
+
+        // The ring of ready boards: only the producer moves 'tail' and only the consumer moves 'head'
+        Slot                  slots[BOARD_POOL_SIZE];
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+
+        std::atomic<uint64_t> wanted{0}; // the settings the producer makes boards for
+        std::atomic<bool>     running{false};
+        std::thread           producer;
+
+        // The producer sleeps on it while the pool is full, the queue itself takes no locks
+        std::mutex              sleep_mutex;
+        std::condition_variable wake;
+
+        void wake_producer() {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake.notify_one();
+        }
+
+        bool is_full(uint64_t t) {
+            return t - head.load(std::memory_order_acquire) >= BOARD_POOL_SIZE;
+        }
+
+        void produce() {
+            while (running.load(std::memory_order_acquire)) {
+                const uint64_t t = tail.load(std::memory_order_relaxed);
+                if (is_full(t)) {
+                    std::unique_lock<std::mutex> lock(sleep_mutex);
+                    wake.wait(lock, [t] { return !running.load(std::memory_order_acquire) || !is_full(t); });
+                    continue;
+                }
+                const uint64_t key = wanted.load(std::memory_order_acquire);
+                const int board_size = (int)(key >> 32),
+                          black_holes = (int)(uint32_t)key;
+                auto board = make_game_board(board_size, GameSettings::getSettings().get_topology()); // Set before start()
+                board->setup(board_size, randoms(black_holes, 0, board_size * board_size - 1));
+                slots[t % BOARD_POOL_SIZE] = Slot{ board.release(), key };
+                tail.store(t + 1, std::memory_order_release);
+            }
+        }
+
+        // Takes the oldest board out of the ring (consumer side)
+        bool pop_slot(Slot& slot) {
+            const uint64_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            slot = slots[h % BOARD_POOL_SIZE];
+            head.store(h + 1, std::memory_order_release);
+            wake_producer();
+            return true;
+        }
+
+    } // namespace
+
+    void start() {
+        if (running.load()) {
+            return;
+        }
+        wanted.store(current_settings_key());
+        running.store(true);
+        producer = std::thread(produce);
+    }
+
+    void stop() {
+        if (!running.load()) {
+            return;
+        }
+        running.store(false);
+        wake_producer();
+        producer.join();
+        Slot slot;
+        while (pop_slot(slot)) {
+            delete slot.board;
+        }
+    }
+
+    void configure() {
+        if (!running.load()) {
+            return;
+        }
+        wanted.store(current_settings_key(), std::memory_order_release);
+        // A board in the making for the old settings is dropped later by pop()
+        Slot slot;
+        while (pop_slot(slot)) {
+            delete slot.board;
+        }
+    }
+
+    std::unique_ptr<GameBoard> pop() {
+        if (!running.load()) {
+            return nullptr;
+        }
+        const uint64_t key = current_settings_key();
+        if (key != wanted.load(std::memory_order_acquire)) { // The settings were changed bypassing configure()
+            configure();
+            return nullptr;
+        }
+        Slot slot;
+        while (pop_slot(slot)) {
+            if (slot.key == key) {
+                return std::unique_ptr<GameBoard>(slot.board);
+            }
+            delete slot.board;
+        }
+        return nullptr;
+    }
+
+} // namespace BoardPool
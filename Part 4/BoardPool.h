@@ -0,0 +1,28 @@
+#ifndef BoardPool_h
+#define BoardPool_h
+
+//
+// Background pool of ready random boards for the current game settings.
+// A producer thread keeps a bounded single-producer/single-consumer lock-free queue filled,
+// so that starting a new game just pops a board.
+//
+
+#include <memory>
+
+class GameBoard;
+
+namespace BoardPool {
+
+    // Starts and stops the producer thread
+    void start();
+    void stop();
+
+    // Drops the boards made for the previous settings and refills the pool for the current ones
+    void configure();
+
+    // A ready board for the current settings, or nullptr if the pool has none (or is not started)
+    std::unique_ptr<GameBoard> pop();
+
+} // namespace BoardPool
+
+#endif // BoardPool_h
@@ -0,0 +1,166 @@
+//
+// BoardSymmetry.cpp
+//
+#include <cassert>
+#include <unordered_set>
+
+#include "BoardSymmetry.h"
+
+namespace BoardSymmetry {
+
+    namespace {
+
+        static_assert(MAX_BOARD_SIZE <= 16, "A row of the hole mask is a 16-bit word");
+
+        uint16_t reverse_bits(uint16_t x) {
+            x = (uint16_t)(((x >> 1) & 0x5555) | ((x & 0x5555) << 1));
+            x = (uint16_t)(((x >> 2) & 0x3333) | ((x & 0x3333) << 2));
+            x = (uint16_t)(((x >> 4) & 0x0F0F) | ((x & 0x0F0F) << 4));
+            return (uint16_t)((x >> 8) | (x << 8));
+        }
+
+        // Mirrors the columns: reverses the 16 bits of each row and shifts the n bits of the board back to the bottom
+        HoleMask flip_horizontal(const HoleMask& mask) {
+            HoleMask result;
+            result.n = mask.n;
+            for (auto row = 0; row < mask.n; row++) {
+                result.rows[row] = (uint16_t)(reverse_bits(mask.rows[row]) >> (16 - mask.n));
+            }
+            return result;
+        }
+
+        HoleMask flip_vertical(const HoleMask& mask) {
+            HoleMask result;
+            result.n = mask.n;
+            for (auto row = 0; row < mask.n; row++) {
+                result.rows[row] = mask.rows[mask.n - 1 - row];
+            }
+            return result;
+        }
+
+        // Transposes the 16x16 bit matrix by swapping its off-diagonal blocks of 8, 4, 2 and 1 bits.
+        // The n x n board is in the top left corner, so it stays there.
+        HoleMask transpose(const HoleMask& mask) {
+            HoleMask result;
+            result.n = mask.n;
+            uint16_t a[16] = {};
+            for (auto row = 0; row < mask.n; row++) {
+                a[row] = mask.rows[row];
+            }
+            uint16_t m = 0xFF00;
+            for (int j = 8; j; j >>= 1, m ^= (uint16_t)(m >> j)) {
+                for (int k = 0; k < 16; k = ((k | j) + 1) & ~j) {
+                    const uint16_t t = (uint16_t)((a[k] ^ (a[k | j] << j)) & m);
+                    a[k] ^= t;
+                    a[k | j] ^= (uint16_t)(t >> j);
+                }
+            }
+            for (auto row = 0; row < mask.n; row++) {
+                result.rows[row] = a[row];
+            }
+            return result;
+        }
+
+    } // namespace
+
+    size_t HoleMaskHash::operator()(const HoleMask& mask) const {
+        uint64_t words[MAX_BOARD_SIZE / 4] = {};
+        for (auto row = 0; row < MAX_BOARD_SIZE; row++) {
+            words[row / 4] |= (uint64_t)mask.rows[row] << (row % 4 * 16);
+        }
+        uint64_t h = zobrist_board(mask.n);
+        for (auto w : words) {
+            h = zobrist_mix(h ^ w);
+        }
+        return (size_t)h;
+    }
+
+    HoleMask pack(int n, const std::vector<int>& holes) {
+        assert(n > 0 && n <= MAX_BOARD_SIZE);
+        HoleMask mask;
+        mask.n = n;
+        for (auto i : holes) {
+            assert(0 <= i && i < n * n);
+            mask.rows[i / n] |= (uint16_t)(1u << (i % n));
+        }
+        return mask;
+    }
+
+    std::vector<int> unpack(const HoleMask& mask) {
+        std::vector<int> holes;
+        for (auto row = 0; row < mask.n; row++) {
+            for (unsigned bits = mask.rows[row]; bits; bits &= bits - 1) {
+                holes.push_back(row * mask.n + __builtin_ctz(bits));
+            }
+        }
+        return holes;
+    }
+
+    HoleMask transform(const HoleMask& mask, Transform t) {
+        switch (t) {
+        case Transform::Rotate90:       return flip_horizontal(transpose(mask));
+        case Transform::Rotate180:      return flip_vertical(flip_horizontal(mask));
+        case Transform::Rotate270:      return flip_vertical(transpose(mask));
+        case Transform::FlipHorizontal: return flip_horizontal(mask);
+        case Transform::FlipVertical:   return flip_vertical(mask);
+        case Transform::Transpose:      return transpose(mask);
+        case Transform::AntiTranspose:  return flip_vertical(flip_horizontal(transpose(mask)));
+        default:                        return mask;
+        }
+    }
+
+    /*
+        Function: canonicalize
+        Parameters:
+            mask - the black holes of a board
+            canonical - receives the smallest of the 8 transforms of the mask
+
+        Description: makes all 8 transforms out of one transpose and the two flips of the mask and of its transpose,
+        so a board costs a single bit matrix transpose and a few word operations per row.
+
+        Returns: the transform t, so that transform(mask, t) == canonical
+    */
+    Transform canonicalize(const HoleMask& mask, HoleMask& canonical) {
+        const HoleMask transposed = transpose(mask);
+        const HoleMask h = flip_horizontal(mask),
+                       th = flip_horizontal(transposed);
+        const std::pair<Transform, HoleMask> candidates[BOARD_SYMMETRIES] = {
+            { Transform::Identity, mask },
+            { Transform::FlipHorizontal, h },
+            { Transform::FlipVertical, flip_vertical(mask) },
+            { Transform::Rotate180, flip_vertical(h) },
+            { Transform::Transpose, transposed },
+            { Transform::Rotate90, th },
+            { Transform::Rotate270, flip_vertical(transposed) },
+            { Transform::AntiTranspose, flip_vertical(th) }
+        };
+        int best = 0;
+        for (int k = 1; k < BOARD_SYMMETRIES; k++) {
+            if (candidates[k].second < candidates[best].second) {
+                best = k;
+            }
+        }
+        canonical = candidates[best].second;
+        return candidates[best].first;
+    }
+
+    size_t deduplicate(int n, std::vector<std::vector<int>>& boards) {
+        std::unordered_set<HoleMask, HoleMaskHash> seen;
+        seen.reserve(boards.size());
+        size_t kept = 0;
+        for (size_t i = 0; i < boards.size(); i++) {
+            HoleMask canonical;
+            canonicalize(pack(n, boards[i]), canonical);
+            if (seen.insert(canonical).second) {
+                if (kept != i) {
+                    boards[kept] = std::move(boards[i]);
+                }
+                kept++;
+            }
+        }
+        const size_t removed = boards.size() - kept;
+        boards.resize(kept);
+        return removed;
+    }
+
+} // namespace BoardSymmetry
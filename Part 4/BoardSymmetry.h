@@ -0,0 +1,109 @@
+#ifndef BoardSymmetry_h
+#define BoardSymmetry_h
+
+//
+// The 8 symmetries of a square board (rotations and reflections). Equivalent boards play the same,
+// so corpora and caches keep one canonical orientation: the lexicographically smallest of the 8.
+// The transform to it is returned too, so that results computed for the canonical board can be mapped back.
+//
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "GameData.h"
+
+#define BOARD_SYMMETRIES 8
+
+namespace BoardSymmetry {
+
+    // The cell (row, col) of the board moves to apply(t, n, row, col) of the transformed board
+    enum class Transform : unsigned char {
+        Identity,
+        Rotate90,       // clockwise
+        Rotate180,
+        Rotate270,
+        FlipHorizontal, // mirrors the columns
+        FlipVertical,   // mirrors the rows
+        Transpose,      // mirrors over the main diagonal
+        AntiTranspose   // mirrors over the other diagonal
+    };
+
+    inline std::pair<int, int> apply(Transform t, int n, int row, int col) {
+        switch (t) {
+        case Transform::Rotate90:       return { col, n - 1 - row };
+        case Transform::Rotate180:      return { n - 1 - row, n - 1 - col };
+        case Transform::Rotate270:      return { n - 1 - col, row };
+        case Transform::FlipHorizontal: return { row, n - 1 - col };
+        case Transform::FlipVertical:   return { n - 1 - row, col };
+        case Transform::Transpose:      return { col, row };
+        case Transform::AntiTranspose:  return { n - 1 - col, n - 1 - row };
+        default:                        return { row, col };
+        }
+    }
+
+    // The transform that undoes t
+    inline Transform inverse(Transform t) {
+        return Transform::Rotate90 == t ? Transform::Rotate270 : Transform::Rotate270 == t ? Transform::Rotate90 : t;
+    }
+
+    // The black holes of a board up to MAX_BOARD_SIZE: one 16-bit word per row, the bit c for the column c.
+    // The rows compare as numbers, which gives the order of the masks.
+    struct HoleMask {
+        int                                  n = 0;
+        std::array<uint16_t, MAX_BOARD_SIZE> rows{};
+
+        bool operator==(const HoleMask& other) const { return n == other.n && rows == other.rows; }
+        bool operator<(const HoleMask& other) const { return n != other.n ? n < other.n : rows < other.rows; }
+    };
+
+    struct HoleMaskHash {
+        size_t operator()(const HoleMask& mask) const;
+    };
+
+    // Holes are indexes row * n + col
+    HoleMask pack(int n, const std::vector<int>& holes);
+    std::vector<int> unpack(const HoleMask& mask);
+
+    HoleMask transform(const HoleMask& mask, Transform t);
+
+    // Finds the smallest of the 8 transforms of the mask. Returns the transform t, so that transform(mask, t) == canonical.
+    Transform canonicalize(const HoleMask& mask, HoleMask& canonical);
+
+    // Removes the boards equivalent to a board before them, keeps the order of the rest. Returns the number of boards removed.
+    size_t deduplicate(int n, std::vector<std::vector<int>>& boards);
+
+    // Any grid of n * n cells, e.g. a visible position: copies the smallest of its 8 transforms to 'canonical'.
+    // Returns the transform t, so that canonical[apply(t, row, col)] == cells[row * n + col].
+    template <class Cell>
+    Transform canonicalize(int n, const std::vector<Cell>& cells, std::vector<Cell>& canonical) {
+        // The cell of the grid that the transform t moves to the position p
+        auto source = [n](Transform t, int p) {
+            const auto cell = apply(inverse(t), n, p / n, p % n);
+            return cell.first * n + cell.second;
+        };
+        Transform best = Transform::Identity;
+        for (int k = 1; k < BOARD_SYMMETRIES; k++) {
+            const Transform t = (Transform)k;
+            for (int p = 0; p < n * n; p++) {
+                const Cell a = cells[source(t, p)],
+                           b = cells[source(best, p)];
+                if (a != b) {
+                    if (a < b) {
+                        best = t;
+                    }
+                    break;
+                }
+            }
+        }
+        canonical.resize(cells.size());
+        for (int p = 0; p < n * n; p++) {
+            canonical[p] = cells[source(best, p)];
+        }
+        return best;
+    }
+
+} // namespace BoardSymmetry
+
+#endif // BoardSymmetry_h
@@ -0,0 +1,243 @@
+//
+// GameAnalytics.cpp
+//
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "GameAnalytics.h"
+#include "GameData.h"
+#include "Helpers.h"
+
+namespace {
+
+    // Consecutive boards of the corpus or of the seed range, the unit of work of a thread
+    struct Batch {
+        std::vector<std::string> files;          // the board files of the corpus
+        uint64_t                 first_seed = 0; // otherwise the seeds first_seed..first_seed + count - 1
+        int                      count = 0;
+        std::string              rows;           // the metrics of the boards, ready to be written
+        std::string              errors;         // the boards that cannot be read
+        int                      skipped = 0;
+        bool                     done = false;
+    };
+
+    // The name of the board as a CSV field or a JSON string
+    void append_name(std::string& out, const std::string& name, bool json) {
+        const bool quote = json || std::string::npos != name.find_first_of(",\"");
+        if (quote) {
+            out += '"';
+        }
+        for (char c : name) {
+            if ('"' == c) {
+                out += json ? "\\\"" : "\"\"";
+            }
+            else if ('\\' == c && json) {
+                out += "\\\\";
+            }
+            else {
+                out += c;
+            }
+        }
+        if (quote) {
+            out += '"';
+        }
+    }
+
+    // The rows of the boards of the batch, the board of the thread is reused while the size stays the same
+    void analyze_batch(Batch& batch, const TournamentBoards& spec, bool json, BoardTopology topology, std::unique_ptr<GameBoard>& board) {
+        for (int k = 0; k < batch.count; k++) {
+            std::string name;
+            std::vector<int> holes;
+            int n = spec.size;
+            if (!batch.files.empty()) {
+                name = batch.files[k];
+                unsigned int size = 0;
+                holes = black_holes_from_file(name.c_str(), size);
+                n = (int)size;
+                const bool on_board = std::all_of(holes.begin(), holes.end(), [n](int i) { return 0 <= i && i < n * n; });
+                if (n < MIN_BOARD_SIZE || !on_board) {
+                    batch.errors += "The board " + name + " of the corpus is not valid\n";
+                    batch.skipped++;
+                    continue;
+                }
+            }
+            else {
+                name = std::to_string(batch.first_seed + k);
+                holes = TournamentBlackHoles(spec, batch.first_seed + k);
+            }
+            if (!board || board->board_size() != n) {
+                board = make_game_board(n, topology);
+            }
+            board->setup(n, holes);
+            const BoardMetrics metrics = board->metrics();
+
+            char line[256];
+            if (json) {
+                batch.rows += ",\n{\"board\":";
+                append_name(batch.rows, name, json);
+                std::snprintf(line, sizeof(line), ",\"size\":%d,\"black_holes\":%d,\"3bv\":%d,\"openings\":%d,\"isolated\":%d,\"zero_cells\":%d,\"safe_cells\":%d}",
+                    n, (int)holes.size(), metrics.bbbv, metrics.openings, metrics.isolated, metrics.zero_cells, metrics.safe_cells);
+            }
+            else {
+                append_name(batch.rows, name, json);
+                std::snprintf(line, sizeof(line), ",%d,%d,%d,%d,%d,%d,%d\n",
+                    n, (int)holes.size(), metrics.bbbv, metrics.openings, metrics.isolated, metrics.zero_cells, metrics.safe_cells);
+            }
+            batch.rows += line;
+        }
+    }
+
+} // namespace
+
+/*
+    Function: RunAnalytics
+    Parameters:
+        filename - the file for the results, nullptr for stdout
+        json - write JSON instead of CSV
+        spec - the corpus, or the seeds and the board of the seed range (as for the tournament)
+
+    Description: the main thread reads the batches and hands them to the threads through a queue, then writes
+    the batch at the front of the ones in flight as soon as it is done, so the rows keep the order of the corpus
+    whatever thread finishes first. The reading stops while ANALYTICS_IN_FLIGHT batches per thread wait to be written.
+    The number of boards and their rate are reported to stderr at the end.
+
+    Returns: 0 on success, 1 if the boards are not valid, a board was skipped or the results cannot be written
+*/
+int RunAnalytics(const char* filename, bool json, const TournamentBoards& spec) {
+    std::ifstream corpus;
+    if (!spec.corpus.empty()) {
+        corpus.open(spec.corpus);
+        if (!corpus) {
+            std::cerr << "Cannot read the corpus " << spec.corpus << "\n";
+            return 1;
+        }
+    }
+    else if (spec.size < MIN_BOARD_SIZE || spec.black_holes < 0 || spec.black_holes > spec.size * spec.size || spec.seeds < 1) {
+        std::cerr << "The boards of the analytics are not valid\n";
+        return 1;
+    }
+    uint64_t next_seed = spec.first_seed;
+    const uint64_t last_seed = spec.first_seed + (uint64_t)std::max(0, spec.seeds);
+    auto read_batch = [&](Batch& batch) {
+        if (corpus.is_open()) {
+            std::string file;
+            while ((int)batch.files.size() < ANALYTICS_BATCH && std::getline(corpus, file)) {
+                if (!file.empty()) {
+                    batch.files.push_back(file);
+                }
+            }
+            batch.count = (int)batch.files.size();
+        }
+        else {
+            batch.first_seed = next_seed;
+            batch.count = (int)std::min<uint64_t>(ANALYTICS_BATCH, last_seed - next_seed);
+            next_seed += batch.count;
+        }
+        return batch.count > 0;
+    };
+
+    std::ofstream file;
+    if (filename) {
+        file.open(filename, std::ios::trunc);
+    }
+    std::ostream& os = filename ? file : std::cout;
+
+    const BoardTopology topology = GameSettings::getSettings().get_topology();
+    const int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::mutex                         queue_mutex;
+    std::condition_variable            work_ready, batch_done;
+    std::deque<std::unique_ptr<Batch>> in_flight; // in the order of the corpus
+    std::queue<Batch*>                 pending;   // not taken by a thread yet
+    bool                               input_end = false;
+
+    auto work = [&] {
+        std::unique_ptr<GameBoard> board;
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        while (true) {
+            work_ready.wait(lock, [&] { return !pending.empty() || input_end; });
+            if (pending.empty()) {
+                return;
+            }
+            Batch* batch = pending.front();
+            pending.pop();
+            lock.unlock();
+            analyze_batch(*batch, spec, json, topology, board);
+            lock.lock();
+            batch->done = true;
+            batch_done.notify_one();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(work);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    os << (json ? "{\"boards\":[" : "board,size,black_holes,3bv,openings,isolated,zero_cells,safe_cells\n");
+    size_t boards = 0;
+    int skipped = 0;
+    bool first = true;
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true) {
+        while (!input_end && (int)in_flight.size() < threads * ANALYTICS_IN_FLIGHT) {
+            lock.unlock();
+            auto batch = std::make_unique<Batch>();
+            const bool more = read_batch(*batch);
+            lock.lock();
+            if (!more) {
+                input_end = true;
+                work_ready.notify_all();
+                break;
+            }
+            pending.push(batch.get());
+            in_flight.push_back(std::move(batch));
+            work_ready.notify_one();
+        }
+        if (in_flight.empty()) {
+            break;
+        }
+        batch_done.wait(lock, [&] { return in_flight.front()->done; });
+        std::unique_ptr<Batch> batch = std::move(in_flight.front());
+        in_flight.pop_front();
+        lock.unlock();
+        std::cerr << batch->errors;
+        if (!batch->rows.empty()) {
+            const size_t separator = (json && first) ? 1 : 0; // The first row has no comma before it
+            os.write(batch->rows.data() + separator, batch->rows.size() - separator);
+            first = false;
+        }
+        boards += batch->count - batch->skipped;
+        skipped += batch->skipped;
+        lock.lock();
+    }
+    lock.unlock();
+    for (auto& t : workers) {
+        t.join();
+    }
+    if (json) {
+        os << "\n]}\n";
+    }
+    os.flush();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Analytics: " << boards << " boards, " << skipped << " skipped, " << seconds << " s, "
+        << (int)(seconds > 0 ? boards / seconds : 0) << " boards per second\n";
+    if (!os) {
+        std::cerr << "Cannot write the results to " << (filename ? filename : "stdout") << "\n";
+        return 1;
+    }
+    if (0 == boards + skipped) {
+        std::cerr << "The corpus " << spec.corpus << " has no boards\n";
+        return 1;
+    }
+    return skipped ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+#ifndef GameAnalytics_h
+#define GameAnalytics_h
+
+//
+// Board analytics: the difficulty metrics of every board of a corpus (or of a range of seeds, the boards of the
+// tournament), see BoardMetrics: 3BV, the openings and the isolated numbered cells. The corpus is streamed: the main
+// thread reads the names of the board files in batches of ANALYTICS_BATCH, all hardware threads read the boards and
+// compute their metrics, and the main thread writes the rows of the batches in the order of the corpus, with at most
+// ANALYTICS_IN_FLIGHT batches per thread read ahead. A corpus of any length runs in constant memory.
+//
+
+#include "GameTournament.h"
+
+#define ANALYTICS_BATCH     64 // boards of a batch
+#define ANALYTICS_IN_FLIGHT 4  // batches per thread read and not written yet
+
+// Writes a row of metrics for each board as CSV (or JSON) to the file or stdout, the boards are made
+// with the topology of the game settings. A board that cannot be read is reported and skipped.
+// Returns 0 on success, 1 if the boards are not valid, a board was skipped or the results cannot be written.
+int RunAnalytics(const char* filename, bool json, const TournamentBoards& boards);
+
+#endif // GameAnalytics_h
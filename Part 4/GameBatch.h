@@ -0,0 +1,241 @@
+#ifndef GameBatch_h
+#define GameBatch_h
+
+//
+// Lock-step engine for many small boards of the same size: BATCH_LANES independent games kept
+// in structure-of-arrays form, each cell is a vector with one byte lane per game. Setup, reveals
+// and win checks run for all lanes at once with the GCC/Clang vector extensions: 16 lanes in an SSE2
+// register by default, 32 lanes with -mavx2. The lanes whose games have finished are masked out.
+//
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "GameController.h"
+#include "GameData.h"
+
+#ifdef __AVX2__
+#define BATCH_LANES 32 // one 256-bit vector
+#else
+#define BATCH_LANES 16 // one SSE2 register: wider vectors are split into pairs of instructions and lose to the scalar board
+#endif
+
+typedef uint8_t LaneVector __attribute__((vector_size(BATCH_LANES)));
+
+template <int N>
+class BoardBatch {
+    static_assert(N >= MIN_BOARD_SIZE && N <= MAX_BOARD_SIZE, "Batches are made of small boards");
+    static_assert(N * N - MIN_BLACK_HOLES <= 255, "Hidden cells are counted in byte lanes");
+
+public:
+    static constexpr int lanes = BATCH_LANES;
+
+private:
+    // The padded layout of FixedStorage<N>: the board inside a one-cell sentinel border
+    static constexpr int stride = N + 2;
+    static constexpr int cells = stride * stride;
+    static constexpr std::array<int, 8> offsets = neighbour_offsets(stride);
+
+    LaneVector hole[cells];
+    LaneVector nearby[cells];
+    LaneVector zero[cells];   // 0xFF if the opened cell opens its neighbours: no black holes nearby and not a hole itself
+    LaneVector opened[cells]; // sentinel cells are opened from the start, so the fill never adds them
+    LaneVector spread[cells]; // 0xFF if the zero cell has opened its neighbours already
+    GameState  state[lanes];
+
+    static constexpr int index(int row, int col) {
+        return (row + 1) * stride + col + 1;
+    }
+
+    static bool any(const LaneVector& v) {
+        uint64_t words[sizeof(LaneVector) / sizeof(uint64_t)];
+        std::memcpy(words, &v, sizeof(words));
+        uint64_t result = 0;
+        for (auto w : words) {
+            result |= w;
+        }
+        return result != 0;
+    }
+
+    LaneVector hidden;        // closed cells without black holes, per lane
+
+    // Cells to spread, shared by all lanes, each cell is queued at most once at a time
+    int           queue[cells];
+    unsigned char queued[cells];
+    int           queue_head = 0,
+                  queue_size = 0;
+
+    void push(int c) {
+        if (!queued[c]) {
+            queued[c] = 1;
+            queue[(queue_head + queue_size++) % cells] = c;
+        }
+    }
+
+    // Opens the zero areas of the cells queued: a breadth-first fill over the union of the areas of all lanes.
+    // Each zero cell opens its neighbours once per lane, so a game costs no more than its board.
+    void fill() {
+        while (queue_size) {
+            const int c = queue[queue_head];
+            queue_head = (queue_head + 1) % cells;
+            queue_size--;
+            queued[c] = 0;
+
+            const LaneVector z = opened[c] & zero[c] & ~spread[c];
+            if (!any(z)) {
+                continue;
+            }
+            spread[c] |= z;
+#pragma GCC unroll 8
+            for (auto offset : offsets) {
+                const LaneVector added = z & ~opened[c + offset];
+                if (any(added)) {
+                    opened[c + offset] |= added;
+                    hidden -= added & 1; // Zero cells have no black holes around
+                    if (any(added & zero[c + offset])) {
+                        push(c + offset);
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    BoardBatch() {
+        reset();
+    }
+
+    // Clears all lanes, no lane is in play until compute_adjacent_black_holes
+    void reset() {
+        std::memset(hole, 0, sizeof(hole));
+        std::memset(nearby, 0, sizeof(nearby));
+        std::memset(zero, 0, sizeof(zero));
+        std::memset(opened, 0xFF, sizeof(opened));
+        for (auto row = 0; row < N; row++) {
+            std::memset(&opened[index(row, 0)], 0, N * sizeof(LaneVector));
+        }
+        std::memset(spread, 0, sizeof(spread));
+        std::memset(queued, 0, sizeof(queued));
+        queue_head = queue_size = 0;
+        hidden = LaneVector{};
+        for (auto& s : state) {
+            s = GameState::None;
+        }
+    }
+
+    // Places the black holes of the lane, indexes are row * N + col
+    void set_black_holes(int lane, const std::vector<int>& holes) {
+        assert(0 <= lane && lane < lanes);
+        for (auto i : holes) {
+            assert(0 <= i && i < N * N);
+            hole[index(i / N, i % N)][lane] = 1;
+        }
+        hidden[lane] = (uint8_t)(N * N - holes.size());
+        state[lane] = GameState::Play;
+    }
+
+    // Counts the black holes nearby for all lanes at once
+    void compute_adjacent_black_holes() {
+        for (auto row = 0; row < N; row++) {
+            for (auto col = 0; col < N; col++) {
+                const int c = index(row, col);
+                LaneVector sum = {};
+#pragma GCC unroll 8
+                for (auto offset : offsets) {
+                    sum += hole[c + offset];
+                }
+                nearby[c] = sum;
+                zero[c] = (LaneVector)((sum == 0) & (hole[c] == 0));
+            }
+        }
+    }
+
+    // Sets up the boards of up to 'lanes' games, the lanes without a board stay out of play
+    void setup(const std::vector<std::vector<int>>& boards) {
+        assert(boards.size() <= (size_t)lanes);
+        reset();
+        for (auto lane = 0u; lane < boards.size(); lane++) {
+            set_black_holes(lane, boards[lane]);
+        }
+        compute_adjacent_black_holes();
+    }
+
+    /*
+        Function: move
+        Parameters:
+            rows, cols - zero-based cell to open in each lane
+            results - receives the result of each lane, as DoMove would return it for the board of the lane
+
+        Description: applies one move to every lane in play. The lanes whose games have finished (or have no board)
+        are masked out, their move is not applied and their result is MoveResult::Invalid.
+    */
+    void move(const int rows[], const int cols[], MoveResult results[]) {
+        LaneVector lost = {};
+        bool any_lost = false,
+             any_opened = false;
+        for (auto lane = 0; lane < lanes; lane++) {
+            const int row = rows[lane], col = cols[lane];
+            if (GameState::Play != state[lane] || row < 0 || col < 0 || row >= N || col >= N) {
+                results[lane] = MoveResult::Invalid;
+            }
+            else if (opened[index(row, col)][lane]) {
+                results[lane] = MoveResult::AlreadyOpened;
+            }
+            else if (hole[index(row, col)][lane]) {
+                results[lane] = MoveResult::Lost;
+                state[lane] = GameState::Lost;
+                lost[lane] = 0xFF;
+                any_lost = true;
+            }
+            else {
+                results[lane] = MoveResult::Opened;
+                opened[index(row, col)][lane] = 0xFF;
+                hidden[lane]--;
+                any_opened = true;
+                if (zero[index(row, col)][lane]) {
+                    push(index(row, col));
+                }
+            }
+        }
+
+        if (any_lost) { // Open the black holes of the lanes lost
+            for (auto c = 0; c < cells; c++) {
+                opened[c] |= (LaneVector)(hole[c] != 0) & lost;
+            }
+        }
+        if (any_opened) {
+            fill();
+            for (auto lane = 0; lane < lanes; lane++) {
+                if (MoveResult::Opened == results[lane] && 0 == hidden[lane]) {
+                    results[lane] = MoveResult::Win;
+                    state[lane] = GameState::Win;
+                }
+            }
+        }
+    }
+
+    bool is_opened_cell(int lane, int row, int col) const {
+        return opened[index(row, col)][lane] != 0;
+    }
+
+    bool is_black_hole_cell(int lane, int row, int col) const {
+        return hole[index(row, col)][lane] != 0;
+    }
+
+    int black_holes_nearby(int lane, int row, int col) const {
+        return nearby[index(row, col)][lane];
+    }
+
+    int hidden_cells(int lane) const {
+        return hidden[lane];
+    }
+
+    GameState game_state(int lane) const {
+        return state[lane];
+    }
+};
+
+#endif // GameBatch_h
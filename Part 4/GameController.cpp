@@ -2,11 +2,16 @@
 // GameController.cpp
 //
 #include "GameController.h"
+#include "BoardPool.h"
 #include "GameData.h"
+#include "GameHint.h"
+#include "GameSnapshot.h"
+#include "GameTelemetry.h"
 #include "GameUI.h"
 
 #include "Helpers.h"
 
+#include <cstdio>
 #include <string>
 
 /*
@@ -34,32 +39,96 @@ void DoSettings() {
     // Applying new settings
     GameSettings::getSettings().set_board_size(board_size);
     GameSettings::getSettings().set_black_holes(black_holes);
+    BoardPool::configure(); // Refill the pool with boards for the new settings
 }
 
 /*
-    Function: DoPlay
+    Function: apply_move
     Parameters:
-        debug_mode  - allows to display secondary "debug" game board
-        filename - file with specified game conditions, e.g.
+        game_board - the board of the current game
+        row, col - zero-based cell to open
 
-0 1 0 1 0 0
-0 0 0 0 0 0
-0 1 1 0 0 0
-1 0 0 0 0 0
-0 0 0 0 1 0
-0 0 0 0 0 1
+    Description: applies one player move to the board and updates the game state
 
-        where 1 means a black hole cell, 0 means a normal cell
+    Returns MoveResult, see DoMove
 
-    Description: initializes and starts a new game
+*/
+static MoveResult apply_move(GameBoard& game_board, int row, int col) {
+    if (!game_board.is_valid_cell(row, col)) {
+        return MoveResult::Invalid;
+    }
+    if (game_board.is_opened_cell(row, col)) {
+        return MoveResult::AlreadyOpened;
+    }
+    if (game_board.is_black_hole_cell(row, col)) { // If it is a hole, it's game over
+        game_board.open_black_holes();
+        game_board.Lost();
+        return MoveResult::Lost;
+    }
+    game_board.do_open(row, col);
+    if (game_board.hidden_cells() == 0) { // If there are no hidden cells, the game is over
+        game_board.Win();
+        return MoveResult::Win;
+    }
+    return MoveResult::Opened;
+}
 
-    Returns boolean:
-        false if specified file does not exist or has invalid content
-        Always returns true if filename==nullptr
+/*
+    Function: DoMove
+    Parameters:
+        game_board - the board of the current game
+        row, col - zero-based cell to open
+
+    Description: applies one player move to the board and updates the game state.
+    The observers of the board get what the move changed as one delta (see GameBoard::subscribe).
+    With the telemetry on, the move, the cells it opened and its time are recorded (see GameTelemetry)
+
+    Returns MoveResult:
+        Invalid - the cell is outside the board
+        AlreadyOpened - the cell was opened before, nothing changed
+        Opened - cells were opened, the game goes on
+        Win, Lost - the move has finished the game
 
 */
-bool DoPlay(bool debug_mode, const char* filename) {
-    GameBoard game_board;
+MoveResult DoMove(GameBoard& game_board, int row, int col) {
+    const GameState before = game_board.game_state();
+    MoveResult result;
+    if (!GameTelemetry::enabled()) {
+        result = apply_move(game_board, row, col);
+    }
+    else {
+        const int hidden = game_board.hidden_cells();
+        const uint64_t start = GameTelemetry::now();
+        result = apply_move(game_board, row, col);
+        GameTelemetry::move(game_board, row, col, result, hidden - game_board.hidden_cells(), start, GameTelemetry::now());
+    }
+    game_board.publish(before);
+    return result;
+}
+
+const char* move_result_name(MoveResult result) {
+    switch (result) {
+    case MoveResult::Invalid:       return "invalid";
+    case MoveResult::AlreadyOpened: return "opened";
+    case MoveResult::Win:           return "win";
+    case MoveResult::Lost:          return "lost";
+    default:                        return "play";
+    }
+}
+
+/*
+    Function: NewGame
+    Parameters:
+        filename - file with specified game conditions (see DoPlay), or nullptr to place black holes randomly
+
+    Description: creates the board of a new game using the current game settings,
+    a random board is taken from the board pool if it has one ready
+
+    Returns the board, the implementation is chosen by the board size and the topology (see make_game_board)
+        nullptr if specified file does not exist or has invalid content
+
+*/
+std::unique_ptr<GameBoard> NewGame(const char* filename) {
     // Initialize new game
     std::vector<int> black_holes;
 
@@ -72,10 +141,16 @@ bool DoPlay(bool debug_mode, const char* filename) {
             GameSettings::getSettings().set_black_holes((int)black_holes.size());
         }
         else {
-            return false;
+            return nullptr;
         }
     }
     else {
+        if (auto game_board = BoardPool::pop()) {
+            if (GameTelemetry::enabled()) {
+                GameTelemetry::game_start(*game_board, GameSettings::getSettings().get_black_holes());
+            }
+            return game_board;
+        }
         // Get random black hole indexes on the board NxN
         black_holes = randoms(GameSettings::getSettings().get_black_holes(), // the number of black holes on the board we need
             0, // the first possible index in the board array where black holes can be placed
@@ -83,39 +158,108 @@ bool DoPlay(bool debug_mode, const char* filename) {
         );
     }
 
-    game_board.setup(GameSettings::getSettings().get_board_size(), black_holes);
+    auto game_board = make_game_board(GameSettings::getSettings().get_board_size(), GameSettings::getSettings().get_topology());
+    game_board->setup(GameSettings::getSettings().get_board_size(), black_holes);
+    if (GameTelemetry::enabled()) {
+        GameTelemetry::game_start(*game_board, (int)black_holes.size());
+    }
+    return game_board;
+}
+
+/*
+    Function: DoPlay
+    Parameters:
+        debug_mode  - allows to display secondary "debug" game board
+        filename - file with specified game conditions, e.g.
+
+0 1 0 1 0 0
+0 0 0 0 0 0
+0 1 1 0 0 0
+1 0 0 0 0 0
+0 0 0 0 1 0
+0 0 0 0 0 1
+
+        where 1 means a black hole cell, 0 means a normal cell
+
+    Description: initializes and starts a new game. With hints on, the position is analyzed
+    in the background while the player is thinking (see GameHint).
+    With a save file, a game saved there is resumed instead of a new random one, and the game is saved
+    after every move. The file is removed when the game is over; a cancelled game stays in it to be resumed (see GameSnapshot)
+
+    Returns boolean:
+        false if specified file does not exist or has invalid content
+        Always returns true if filename==nullptr
 
+*/
+bool DoPlay(bool debug_mode, const char* filename) {
+    const std::string& save_file = GameSettings::getSettings().get_save_file();
+    std::unique_ptr<GameBoard> game_board;
+    if (!filename && !save_file.empty()) {
+        int black_holes = 0;
+        if ((game_board = GameSnapshot::load_file(save_file, black_holes))) {
+            GameSettings::getSettings().set_board_size(game_board->board_size());
+            GameSettings::getSettings().set_black_holes(black_holes);
+            if (GameTelemetry::enabled()) {
+                GameTelemetry::game_start(*game_board, black_holes);
+            }
+            GameUI::showMessage("The saved game is resumed\n");
+        }
+    }
+    if (!game_board) {
+        game_board = NewGame(filename);
+    }
+    if (!game_board) {
+        return false;
+    }
+
+    GameHint::HintWorker hints;
+    GameUI::Viewport view;
     while (true) {
-        GameUI::ShowGameBoard(&game_board, debug_mode);
+        GameUI::ShowGameBoard(game_board.get(), debug_mode, view);
 
-        if (game_board.IsGameover()) {
-            GameUI::showMessage(game_board.IsWin() ? "You won!" : "You lost!");
+        if (game_board->IsGameover()) {
+            GameUI::showMessage(game_board->IsWin() ? "You won!" : "You lost!");
             break;
         }
 
+        if (GameSettings::getSettings().get_hints()) {
+            hints.start(*game_board, GameSettings::getSettings().get_black_holes());
+        }
         int click_row(0), click_col(0);
-        if (!GameUI::getMoveInTheGame(click_row, click_col)) {
+        GameUI::MoveInput input;
+        while (GameUI::MoveInput::Move != (input = GameUI::getMoveInTheGame(click_row, click_col, game_board.get(), view))
+               && GameUI::MoveInput::Cancel != input) {
+            if (GameUI::MoveInput::Hint == input) {
+                GameUI::showHint(hints.get());
+            }
+            else {
+                GameUI::ShowGameBoard(game_board.get(), debug_mode, view);
+            }
+        }
+        hints.cancel(); // The move does not wait for the analysis
+        if (GameUI::MoveInput::Cancel == input) {
             GameUI::showMessage("The game has been cancelled...");
             break;
         }
         click_row--; click_col--; // Because we use zero-based indexes, and for a player they start from 1
-        if (!game_board.is_valid_cell(click_row, click_col)) { // Is that click outside the board?
+        switch (DoMove(*game_board, click_row, click_col)) {
+        case MoveResult::Invalid: // Is that click outside the board?
             GameUI::showMessage("Invalid move entered, try again, e.g. 1 1\n");
-        }
-        else if (game_board.is_opened_cell(click_row, click_col)) { // Was that cell already opened?
+            break;
+        case MoveResult::AlreadyOpened: // Was that cell already opened?
             GameUI::showMessage("This cell is alredy opened, please select another one...\n");
-        }
-        else if (game_board.is_black_hole_cell(click_row, click_col)) { // If it is a hole, it's game over
-            game_board.open_black_holes();
-            game_board.Lost();
-        }
-        else {
-            game_board.do_open(click_row, click_col);
-            if (game_board.hidden_cells() == 0) { // If there are no opened cells, the game is over
-                game_board.Win();
+            break;
+        default:
+            if (!save_file.empty() && !game_board->IsGameover() &&
+                !GameSnapshot::save_file(save_file, *game_board)) {
+                GameUI::showMessage(("Cannot save the game to " + save_file).c_str());
             }
+            break;
         }
     }
+    if (!save_file.empty() && game_board->IsGameover()) {
+        std::remove(save_file.c_str()); // Nothing to resume
+    }
     return true;
 }
 
@@ -1,7 +1,23 @@
 #ifndef GameController_h
 #define GameController_h
 
+#include <memory>
+
+class GameBoard;
+
+enum class MoveResult {
+    Invalid,       // the cell is outside the board
+    AlreadyOpened, // the cell has been opened before
+    Opened,        // the game goes on
+    Win,
+    Lost
+};
+
 void DoSettings();
+std::unique_ptr<GameBoard> NewGame(const char* filename = nullptr);
+MoveResult DoMove(GameBoard& game_board, int row, int col);
+// The name of the result in the scripted mode and the telemetry: play, win, lost, invalid, opened
+const char* move_result_name(MoveResult result);
 bool DoPlay(bool debug_mode, const char* filename = nullptr);
 int Run(bool debug, const char* filename);
 
@@ -0,0 +1,519 @@
+//
+// GameData.cpp
+//
+#include "GameData.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+    bool is_zero_cell(const GameCell& cell) {
+        return !cell.border && !cell.black_hole && 0 == cell.nearby;
+    }
+
+    // Runs f(stripe, first_row, last_row) for each of 'stripes' horizontal stripes of the board, one thread per stripe
+    template <class F>
+    void for_each_stripe(int n, int stripes, F f) {
+        std::vector<std::thread> threads;
+        for (int s = 1; s < stripes; s++) {
+            threads.emplace_back(f, s, s * n / stripes, (s + 1) * n / stripes);
+        }
+        f(0, 0, n / stripes);
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    int find_root(const std::vector<int>& parent, int i) {
+        while (parent[i] != i) {
+            i = parent[i];
+        }
+        return i;
+    }
+
+    int find_root(std::vector<int>& parent, int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]]; // Path halving
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // Returns false if a and b are in the same set already
+    bool unite(std::vector<int>& parent, int a, int b) {
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+        return a != b;
+    }
+
+    /*
+        Parallel fill of the zero area around the cell 'index', the cells opened are the same as by the serial fill:
+
+        1. each thread labels the areas of zero cells (8-connected) inside its stripe with a union-find over cell indexes;
+        2. the areas are merged across the borders between stripes;
+        3. each thread marks the zero cells of its stripe that are in the area of the clicked cell;
+        4. each thread opens the cells of its stripe that are marked or have a marked neighbour.
+
+        Every thread writes the cells of its own stripe only, the steps are separated by joining the threads.
+        The tiles of the overview may span two stripes, so each thread counts the cells it opens per tile on its own;
+        the same for the cells opened, which are appended to 'changed' in the order of the stripes.
+    */
+    template <class Storage>
+    int parallel_open(Storage& storage, int index, int threads, uint64_t& hash, TileCounts& tiles, std::vector<int>* changed) {
+        const int n = storage.n;
+        auto& cells = storage.cells;
+        const int stripes = std::max(1, std::min(threads, n / PARALLEL_STRIPE_ROWS));
+
+        std::vector<int> parent(cells.size());
+        for_each_stripe(n, stripes, [&](int, int row0, int row1) {
+            for (auto row = row0; row < row1; row++) {
+                for (auto col = 0; col < n; col++) {
+                    const int i = storage.index(row, col);
+                    parent[i] = i;
+                    if (!is_zero_cell(cells[i])) {
+                        continue;
+                    }
+                    // The neighbours already labelled: W, and NW, N, NE if the row above is in the stripe
+                    const auto& offsets = storage.offsets_at(i);
+                    if (is_zero_cell(cells[i + offsets[WEST]])) {
+                        unite(parent, i, i + offsets[WEST]);
+                    }
+                    if (row > row0) {
+                        for (int k = NORTH_WEST; k <= NORTH_EAST; k++) {
+                            if (is_zero_cell(cells[i + offsets[k]])) {
+                                unite(parent, i, i + offsets[k]);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        for (int s = 1; s < stripes; s++) {
+            const int row = s * n / stripes;
+            for (auto col = 0; col < n; col++) {
+                const int i = storage.index(row, col);
+                if (!is_zero_cell(cells[i])) {
+                    continue;
+                }
+                const auto& offsets = storage.offsets_at(i);
+                for (int k = NORTH_WEST; k <= NORTH_EAST; k++) {
+                    if (is_zero_cell(cells[i + offsets[k]])) {
+                        unite(parent, i, i + offsets[k]);
+                    }
+                }
+            }
+        }
+
+        const int root = find_root(parent, index);
+        const std::vector<int>& roots = parent;
+        std::vector<unsigned char> area(cells.size(), 0);
+        for_each_stripe(n, stripes, [&](int, int row0, int row1) {
+            for (auto row = row0; row < row1; row++) {
+                for (auto col = 0; col < n; col++) {
+                    const int i = storage.index(row, col);
+                    area[i] = is_zero_cell(cells[i]) && find_root(roots, i) == root;
+                }
+            }
+        });
+
+        std::vector<int> opened(stripes, 0);
+        std::vector<uint64_t> hashes(stripes, 0);
+        const int tile_cols = tiles.blocks_per_side(0);
+        std::vector<std::vector<int>> tile_opened(stripes); // of the tile rows of the stripe, from its first row
+        std::vector<std::vector<int>> stripe_cells(changed ? stripes : 0);
+        for_each_stripe(n, stripes, [&](int stripe, int row0, int row1) {
+            std::vector<int>& counts = tile_opened[stripe];
+            counts.assign(((row1 - 1) / VIEW_TILE - row0 / VIEW_TILE + 1) * tile_cols, 0);
+            for (auto row = row0; row < row1; row++) {
+                for (auto col = 0; col < n; col++) {
+                    const int i = storage.index(row, col);
+                    if (cells[i].opened || cells[i].black_hole) {
+                        continue;
+                    }
+                    const auto& offsets = storage.offsets_at(i);
+                    bool open = area[i];
+                    for (auto k = 0u; k < offsets.size() && !open; k++) {
+                        open = area[i + offsets[k]];
+                    }
+                    if (open) {
+                        cells[i].opened = true;
+                        opened[stripe]++;
+                        hashes[stripe] ^= zobrist_key(i, cells[i]);
+                        counts[(row / VIEW_TILE - row0 / VIEW_TILE) * tile_cols + col / VIEW_TILE]++;
+                        if (changed) {
+                            stripe_cells[stripe].push_back(row * n + col);
+                        }
+                    }
+                }
+            }
+        });
+
+        int result = 0;
+        for (auto stripe = 0; stripe < stripes; stripe++) {
+            result += opened[stripe];
+            hash ^= hashes[stripe];
+            const int first = stripe * n / stripes / VIEW_TILE * tile_cols;
+            for (size_t t = 0; t < tile_opened[stripe].size(); t++) {
+                if (tile_opened[stripe][t]) {
+                    tiles.add_tile(first + (int)t, tile_opened[stripe][t], 0);
+                }
+            }
+            if (changed) {
+                changed->insert(changed->end(), stripe_cells[stripe].begin(), stripe_cells[stripe].end());
+            }
+        }
+        return result;
+    }
+
+    // Finds the FixedGameBoard<N> instantiation for the run-time size
+    template <int N>
+    std::unique_ptr<GameBoard> make_fixed_game_board(int size) {
+        if (size == N) {
+            return std::make_unique<FixedGameBoard<N>>();
+        }
+        if constexpr (N < MAX_BOARD_SIZE) {
+            return make_fixed_game_board<N + 1>(size);
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+} // namespace
+
+std::unique_ptr<GameBoard> make_game_board(int size, BoardTopology topology) {
+    switch (topology) {
+    case BoardTopology::VonNeumann: return std::make_unique<TopologyGameBoard<VonNeumannTopology>>(size);
+    case BoardTopology::Hex:        return std::make_unique<TopologyGameBoard<HexTopology>>(size);
+    case BoardTopology::Torus:      return std::make_unique<TopologyGameBoard<TorusTopology>>(size);
+    default:                        break;
+    }
+    if (size >= MIN_BOARD_SIZE && size <= MAX_BOARD_SIZE) {
+        return make_fixed_game_board<MIN_BOARD_SIZE>(size);
+    }
+    if (GameSettings::getSettings().get_tiled_layout()) {
+        return std::make_unique<TiledGameBoard>(size);
+    }
+    return std::make_unique<DynamicGameBoard>(size);
+}
+
+/*
+    Function: TileCounts::reset
+    Parameters:
+        n - the board size
+
+    Description: sizes the levels for the board with no cells opened: level 0 has a block for each tile,
+    each next level has a block for each 2x2 blocks of the level before, up to a single block of the whole board
+
+    Returns: void
+
+*/
+void TileCounts::reset(int n) {
+    side.assign(1, (n + VIEW_TILE - 1) / VIEW_TILE);
+    while (side.back() > 1) {
+        side.push_back((side.back() + 1) / 2);
+    }
+    blocks.resize(side.size());
+    for (size_t level = 0; level < side.size(); level++) {
+        const int size = block_cells((int)level);
+        blocks[level].assign(side[level] * side[level], Block());
+        for (auto row = 0; row < side[level]; row++) {
+            for (auto col = 0; col < side[level]; col++) {
+                blocks[level][row * side[level] + col].cells = (std::min(n, (row + 1) * size) - row * size) * (std::min(n, (col + 1) * size) - col * size);
+            }
+        }
+    }
+    pending.assign(blocks[0].size(), Block());
+    dirty.clear();
+}
+
+/*
+    Function: TileCounts::commit
+    Parameters: void
+
+    Description: adds the pending changes of the tiles to their blocks at the coarser levels,
+    the cost is the number of tiles changed times the number of levels
+
+    Returns: void
+
+*/
+void TileCounts::commit() {
+    for (auto tile : dirty) {
+        int row = tile / side[0],
+            col = tile % side[0];
+        for (size_t level = 1; level < side.size(); level++) {
+            row /= 2;
+            col /= 2;
+            Block& block = blocks[level][row * side[level] + col];
+            block.opened += pending[tile].opened;
+            block.holes += pending[tile].holes;
+        }
+        pending[tile] = Block();
+    }
+    dirty.clear();
+}
+
+/*
+    Function: open_region
+    Parameters:
+        storage - the board storage
+        index - the cell to open
+        threads - threads of the parallel fill, 0 - all hardware threads
+        hash - the Zobrist hash of the visible board to update
+        tiles - the tile counts of the board to update
+        changed - receives the cells opened as row * n + col, nullptr if nobody needs them
+
+    Description: opens the cell like the recursive fill of BasicGameBoard does, using an explicit stack,
+    so that large areas do not overflow the call stack. Once the area grows over PARALLEL_OPEN_BUDGET cells,
+    the rest of it is opened by the parallel fill (square topology only).
+
+    Returns: the number of newly opened cells
+
+*/
+template <class Storage, class Topology>
+int open_region(Storage& storage, int index, int threads, uint64_t& hash, TileCounts& tiles, std::vector<int>* changed) {
+    auto& cells = storage.cells;
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Accounts a cell just opened in the hash and in the tile counts
+    auto revealed = [&](int i) {
+        hash ^= zobrist_key(i, cells[i]);
+        const auto position = storage.position(i);
+        tiles.add(position.first, position.second, cells[i].black_hole);
+        if (changed) {
+            changed->push_back(position.first * storage.n + position.second);
+        }
+    };
+
+    int opened = 1;
+    cells[index].opened = true;
+    revealed(index);
+    std::vector<int> stack;
+    if (0 == cells[index].nearby) {
+        stack.push_back(index);
+    }
+    while (!stack.empty()) {
+        if constexpr (is_square_topology<Topology>) {
+            if (threads > 1 && opened > PARALLEL_OPEN_BUDGET) {
+                // The cells opened so far are a part of the same area, the parallel fill completes it
+                return opened + parallel_open(storage, index, threads, hash, tiles, changed);
+            }
+        }
+        const int i = stack.back();
+        stack.pop_back();
+        for (auto offset : Topology::offsets(storage, i)) {
+            GameCell& cell = cells[i + offset];
+            if (!cell.opened && !cell.border) {
+                cell.opened = true;
+                opened++;
+                revealed(i + offset);
+                if (0 == cell.nearby) {
+                    stack.push_back(i + offset);
+                }
+            }
+        }
+    }
+    return opened;
+}
+
+/*
+    Function: build_region_index
+    Parameters:
+        storage - the board storage
+        index - receives the regions
+
+    Description: labels the regions of connected zero cells with a union-find, then stores the cells of each region
+    (its zero cells and the numbered cells around them) as one contiguous list, so that a click into the region
+    opens exactly the cells the flood fill would open. A numbered cell between two regions is in both lists.
+    The Zobrist hash of each region and its cells per tile are stored too, so a lookup reveal updates the hash
+    and the tile counts of the board at once.
+
+    Returns: void
+
+*/
+template <class Storage>
+void build_region_index(const Storage& storage, RegionIndex& index) {
+    GAME_STATS_TIMER(RegionIndex);
+    const int n = storage.n;
+    const auto& cells = storage.cells;
+
+    std::vector<int> parent(cells.size());
+    for (auto row = 0; row < n; row++) {
+        for (auto col = 0; col < n; col++) {
+            const int i = storage.index(row, col);
+            parent[i] = i;
+            if (!is_zero_cell(cells[i])) {
+                continue;
+            }
+            // The neighbours already labelled: NW, N, NE and W
+            const auto& offsets = storage.offsets_at(i);
+            for (int k = NORTH_WEST; k <= WEST; k++) {
+                if (is_zero_cell(cells[i + offsets[k]])) {
+                    unite(parent, i, i + offsets[k]);
+                }
+            }
+        }
+    }
+
+    // Number the regions in the board order
+    index.region.assign(cells.size(), -1);
+    int regions = 0;
+    for (auto row = 0; row < n; row++) {
+        for (auto col = 0; col < n; col++) {
+            const int i = storage.index(row, col);
+            if (is_zero_cell(cells[i])) {
+                const int root = find_root(parent, i);
+                if (index.region[root] < 0) {
+                    index.region[root] = regions++;
+                }
+                index.region[i] = index.region[root];
+            }
+        }
+    }
+
+    // Calls f(region, cell) once for each cell of each region
+    auto for_each_region_cell = [&](auto f) {
+        for (auto row = 0; row < n; row++) {
+            for (auto col = 0; col < n; col++) {
+                const int i = storage.index(row, col);
+                if (is_zero_cell(cells[i])) {
+                    f(index.region[i], i);
+                }
+                else if (!cells[i].black_hole) {
+                    int seen[8], count = 0;
+                    for (auto offset : storage.offsets_at(i)) {
+                        const int r = index.region[i + offset];
+                        if (r >= 0 && std::find(seen, seen + count, r) == seen + count) {
+                            seen[count++] = r;
+                            f(r, i);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    // Counting sort of the cells by region
+    index.start.assign(regions + 1, 0);
+    for_each_region_cell([&](int r, int) { index.start[r + 1]++; });
+    for (auto r = 0; r < regions; r++) {
+        index.start[r + 1] += index.start[r];
+    }
+    index.cells.resize(index.start[regions]);
+    index.hash.assign(regions, 0);
+    std::vector<int> next(index.start.begin(), index.start.end() - 1);
+    for_each_region_cell([&](int r, int i) {
+        index.cells[next[r]++] = i;
+        index.hash[r] ^= zobrist_key(i, cells[i]);
+    });
+
+    // The cells of each region per tile, so a lookup updates the tile counts per tile instead of per cell
+    TileCounts layout;
+    layout.reset(n);
+    std::vector<int> tile_cells(layout.blocks_per_side(0) * layout.blocks_per_side(0), 0),
+                     touched;
+    index.tile_start.assign(1, 0);
+    index.tiles.clear();
+    for (auto r = 0; r < regions; r++) {
+        for (auto i = index.start[r]; i < index.start[r + 1]; i++) {
+            const auto position = storage.position(index.cells[i]);
+            const int tile = layout.tile(position.first, position.second);
+            if (0 == tile_cells[tile]++) {
+                touched.push_back(tile);
+            }
+        }
+        for (auto tile : touched) {
+            index.tiles.emplace_back(tile, tile_cells[tile]);
+            tile_cells[tile] = 0;
+        }
+        touched.clear();
+        index.tile_start.push_back((int)index.tiles.size());
+    }
+}
+
+/*
+    Function: board_metrics
+    Parameters:
+        storage - the board storage, its nearby counts computed
+
+    Description: visits the cells in the storage order. Each zero cell starts an opening of its own and is united
+    with the zero cells among its neighbours visited before it (a lower index), so every pair of adjacent zero cells
+    is looked at once whatever the layout or the topology; each union that joins two sets merges two openings.
+    A numbered cell with no zero neighbour is isolated. No second pass is needed:
+    the openings are the zero cells less the unions.
+
+    Returns: the metrics of the board
+
+*/
+template <class Storage, class Topology>
+BoardMetrics board_metrics(const Storage& storage) {
+    const auto& cells = storage.cells;
+    std::vector<int> parent(cells.size());
+    BoardMetrics metrics;
+    int unions = 0;
+    for (auto i = 0; i < (int)cells.size(); i++) {
+        const GameCell& cell = cells[i];
+        if (cell.border || cell.black_hole) {
+            continue;
+        }
+        metrics.safe_cells++;
+        if (0 == cell.nearby) {
+            metrics.zero_cells++;
+            parent[i] = i;
+            for (auto offset : Topology::offsets(storage, i)) {
+                if (offset < 0 && is_zero_cell(cells[i + offset])) {
+                    unions += unite(parent, i, i + offset);
+                }
+            }
+        }
+        else {
+            bool next_to_zero = false;
+            for (auto offset : Topology::offsets(storage, i)) {
+                next_to_zero = next_to_zero || is_zero_cell(cells[i + offset]);
+            }
+            metrics.isolated += !next_to_zero;
+        }
+    }
+    metrics.openings = metrics.zero_cells - unions;
+    metrics.bbbv = metrics.openings + metrics.isolated;
+    return metrics;
+}
+
+template int open_region(DynamicStorage&, int, int, uint64_t&, TileCounts&, std::vector<int>*);
+template int open_region(TiledStorage&, int, int, uint64_t&, TileCounts&, std::vector<int>*);
+template int open_region<DynamicStorage, VonNeumannTopology>(DynamicStorage&, int, int, uint64_t&, TileCounts&, std::vector<int>*);
+template int open_region<DynamicStorage, HexTopology>(DynamicStorage&, int, int, uint64_t&, TileCounts&, std::vector<int>*);
+template int open_region<DynamicStorage, TorusTopology>(DynamicStorage&, int, int, uint64_t&, TileCounts&, std::vector<int>*);
+template void build_region_index(const DynamicStorage&, RegionIndex&);
+template void build_region_index(const TiledStorage&, RegionIndex&);
+template BoardMetrics board_metrics<DynamicStorage, SquareTopology>(const DynamicStorage&);
+template BoardMetrics board_metrics<DynamicStorage, VonNeumannTopology>(const DynamicStorage&);
+template BoardMetrics board_metrics<DynamicStorage, HexTopology>(const DynamicStorage&);
+template BoardMetrics board_metrics<DynamicStorage, TorusTopology>(const DynamicStorage&);
+template BoardMetrics board_metrics<TiledStorage, SquareTopology>(const TiledStorage&);
+
+// The fixed sizes MIN_BOARD_SIZE..MAX_BOARD_SIZE
+static_assert(MIN_BOARD_SIZE == 5 && MAX_BOARD_SIZE == 16, "Update the instantiations below");
+#define INSTANTIATE_FIXED_STORAGE(N) \
+    template int open_region(FixedStorage<N>&, int, int, uint64_t&, TileCounts&, std::vector<int>*); \
+    template void build_region_index(const FixedStorage<N>&, RegionIndex&); \
+    template BoardMetrics board_metrics<FixedStorage<N>, SquareTopology>(const FixedStorage<N>&);
+INSTANTIATE_FIXED_STORAGE(5)
+INSTANTIATE_FIXED_STORAGE(6)
+INSTANTIATE_FIXED_STORAGE(7)
+INSTANTIATE_FIXED_STORAGE(8)
+INSTANTIATE_FIXED_STORAGE(9)
+INSTANTIATE_FIXED_STORAGE(10)
+INSTANTIATE_FIXED_STORAGE(11)
+INSTANTIATE_FIXED_STORAGE(12)
+INSTANTIATE_FIXED_STORAGE(13)
+INSTANTIATE_FIXED_STORAGE(14)
+INSTANTIATE_FIXED_STORAGE(15)
+INSTANTIATE_FIXED_STORAGE(16)
@@ -1,9 +1,18 @@
 #ifndef GameData_h
 #define GameData_h
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "GameStats.h"
+
 #define BOARD_SIZE   8 // Default board size is 8x8
 #define BLACK_HOLES 10 // Default black holes count
 
@@ -13,10 +22,23 @@
 #define MIN_BLACK_HOLES 1
 #define MAX_BLACK_HOLES(board_size) (board_size*board_size - 9)
 
+#define LARGE_BOARD_CELLS    (1 << 16) // boards from this size reveal cells without recursion, see open_region
+#define PARALLEL_OPEN_BUDGET (1 << 16) // cells a reveal opens on one thread before it switches to the parallel fill
+#define PARALLEL_STRIPE_ROWS 64        // minimal height of a board stripe filled by one thread
+#define VIEW_TILE            16        // side of the tiles counted for the overview of large boards, see TileCounts
+
+enum class BoardTopology : uint8_t; // see the topology policies below
+
 class GameSettings {
 private:
     int bord_size = BOARD_SIZE;
     int black_holes = BLACK_HOLES;
+    int open_threads = 0;
+    bool region_index = false;
+    bool hints = false;
+    bool tiled_layout = false;
+    BoardTopology topology{}; // Square
+    std::string save_file;
 public:
     static GameSettings& getSettings() {
         static GameSettings settings;
@@ -38,24 +60,80 @@ public:
     int get_black_holes() const {
         return black_holes;
     }
+    // Threads used to reveal large areas, 0 means all hardware threads and 1 disables the parallel fill
+    void set_open_threads(int threads) {
+        open_threads = threads;
+    }
+    int get_open_threads() const {
+        return open_threads;
+    }
+    // Whether the board setup precomputes the zero regions, see RegionIndex
+    void set_region_index(bool on) {
+        region_index = on;
+    }
+    bool get_region_index() const {
+        return region_index;
+    }
+    // Whether boards larger than MAX_BOARD_SIZE use the tiled layout, see TiledStorage
+    void set_tiled_layout(bool on) {
+        tiled_layout = on;
+    }
+    bool get_tiled_layout() const {
+        return tiled_layout;
+    }
+    // Whether the player can ask for hints, see GameHint
+    void set_hints(bool on) {
+        hints = on;
+    }
+    bool get_hints() const {
+        return hints;
+    }
+    // The neighbourhood of the cells of new games, a BoardTopology (see make_game_board)
+    void set_topology(BoardTopology kind) {
+        topology = kind;
+    }
+    BoardTopology get_topology() const {
+        return topology;
+    }
+    // The snapshot of the game in progress, saved after every move and resumed by the next game (see GameSnapshot)
+    void set_save_file(const std::string& filename) {
+        save_file = filename;
+    }
+    const std::string& get_save_file() const {
+        return save_file;
+    }
 
 };
 
 struct GameCell {
     bool  opened;     // if the cell is opened
     bool  black_hole; // if the cell is a black hole
+    bool  border;     // a sentinel cell around the board: never opened, never a black hole
     int   nearby;     // number of adjacent black holes
 };
 
-enum class GameState {
-    None,
-    Play,
-    Win,
-    Lost
-};
+// Zobrist hashing of the visible board: the hash of a position is the XOR of the keys of its opened cells,
+// so every cell a reveal opens updates it with one XOR. A key depends on the index of the cell in the board
+// storage and on what the opened cell shows; it is computed by a 64-bit mixer, so no key table is needed.
+inline uint64_t zobrist_mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull; // splitmix64
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t zobrist_key(int index, const GameCell& cell) {
+    // A lighter mixer than zobrist_mix, since it runs for every cell opened
+    uint64_t x = (((uint64_t)index << 4) | (uint64_t)(cell.black_hole ? 9 : cell.nearby)) * 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 32)) * 0xD6E8FEB86659FD93ull;
+    return x ^ (x >> 32);
+}
+
+// The hash of the board of the size with no cells opened
+inline uint64_t zobrist_board(int size) {
+    return zobrist_mix(~(uint64_t)size);
+}
 
-class GameBoard {
-private:
 /*
               NW  N  NE
                 \ | /
@@ -64,155 +142,793 @@ private:
               SW  S  SE
  
 */
-//                                  NW        N       NE
-        int compass_rose[8][2] = { {-1,-1},{0,-1}, {1, -1},
-//                                   W        H       E
-                                   {-1, 0},        {1, 0},
-//                                  SW        S       SE
-                                   {-1, 1},{0, 1}, {1,  1}
-                                 };
+//                                     NW        N       NE
+constexpr int compass_rose[8][2] = { {-1,-1},{0,-1}, {1, -1},
+//                                      W        H       E
+                                     {-1, 0},        {1, 0},
+//                                     SW        S       SE
+                                     {-1, 1},{0, 1}, {1,  1}
+                                   };
+
+// Positions in compass_rose
+enum Compass {
+    NORTH_WEST, NORTH, NORTH_EAST,
+    WEST,              EAST,
+    SOUTH_WEST, SOUTH, SOUTH_EAST
+};
+
+// Index offsets of the neighbours in the padded board layout with the row length 'stride'
+constexpr std::array<int, 8> neighbour_offsets(int stride) {
+    std::array<int, 8> offsets{};
+    for (auto i = 0u; i < offsets.size(); i++) {
+        offsets[i] = compass_rose[i][1] * stride + compass_rose[i][0];
+    }
+    return offsets;
+}
+
+// Neighbourhood policies of BasicGameBoard: Topology::offsets(storage, index) gives the index offsets of the
+// Topology::neighbours neighbours of the board cell 'index'. The policy is a template parameter, so the loops over
+// the neighbours are compiled for each topology with no virtual calls. The bounded topologies keep the sentinel
+// border of the storages, the torus has no border: its neighbours wrap around the edges of the board.
+enum class BoardTopology : uint8_t {
+    Square,     // 8 neighbours
+    VonNeumann, // 4 neighbours: N, W, E, S
+    Hex,        // 6 neighbours of a hex grid
+    Torus       // 8 neighbours, wrapping around the edges
+};
+
+struct SquareTopology {
+    static constexpr BoardTopology kind = BoardTopology::Square;
+    static constexpr int neighbours = 8;
+
+    template <class Storage>
+    static const std::array<int, 8>& offsets(const Storage& storage, int index) {
+        return storage.offsets_at(index);
+    }
+};
+
+struct VonNeumannTopology {
+    static constexpr BoardTopology kind = BoardTopology::VonNeumann;
+    static constexpr int neighbours = 4;
 
-    GameState             state = GameState::None;
-    int                   n;
-    std::vector<GameCell> board;
+    template <class Storage>
+    static std::array<int, 4> offsets(const Storage& storage, int index) {
+        const auto& square = storage.offsets_at(index);
+        return { square[NORTH], square[WEST], square[EAST], square[SOUTH] };
+    }
+};
 
+// The hex grid in the "odd-r" layout: the odd rows are shifted half a cell to the right,
+// so the neighbours above and below a cell are NW and N in an even row, N and NE in an odd row
+struct HexTopology {
+    static constexpr BoardTopology kind = BoardTopology::Hex;
+    static constexpr int neighbours = 6;
+    static constexpr int directions[2][6] = { { NORTH_WEST, NORTH, WEST, EAST, SOUTH_WEST, SOUTH },
+                                              { NORTH, NORTH_EAST, WEST, EAST, SOUTH, SOUTH_EAST } };
+
+    template <class Storage>
+    static std::array<int, 6> offsets(const Storage& storage, int index) {
+        const auto& square = storage.offsets_at(index);
+        const int* k = directions[storage.position(index).first & 1];
+        return { square[k[0]], square[k[1]], square[k[2]], square[k[3]], square[k[4]], square[k[5]] };
+    }
+};
 
+struct TorusTopology {
+    static constexpr BoardTopology kind = BoardTopology::Torus;
+    static constexpr int neighbours = 8;
+
+    template <class Storage>
+    static std::array<int, 8> offsets(const Storage& storage, int index) {
+        const auto position = storage.position(index);
+        const int n = storage.n;
+        std::array<int, 8> result{};
+        for (auto k = 0; k < 8; k++) {
+            int row = position.first + compass_rose[k][1],
+                col = position.second + compass_rose[k][0];
+            row += ((row < 0) - (row >= n)) * n; // Wraps without a branch
+            col += ((col < 0) - (col >= n)) * n;
+            result[k] = storage.index(row, col) - index;
+        }
+        return result;
+    }
+};
+
+// The region index and the parallel fill label the zero areas in the order of the square neighbourhood
+template <class Topology>
+constexpr bool is_square_topology = std::is_same<Topology, SquareTopology>::value;
+
+// The opened cells of the board counted per VIEW_TILE x VIEW_TILE tile (level 0), and per block of 2^level x 2^level
+// tiles for the coarser levels, so that an overview of a large board is drawn from a few counts instead of all cells.
+// A reveal adds the cells it opens to their tiles, commit() then carries the tiles it changed to the coarser levels.
+class TileCounts {
 public:
-    GameBoard(int size = BOARD_SIZE) {
-        reset(size);
+    struct Block {
+        int cells = 0;  // board cells in the block
+        int opened = 0; // opened cells, black holes included
+        int holes = 0;  // opened black holes
+    };
+
+private:
+    std::vector<int>                side;    // blocks in a row (and a column) of each level
+    std::vector<std::vector<Block>> blocks;  // of each level, row by row
+    std::vector<Block>              pending; // the changes of each tile not carried to the coarser levels yet
+    std::vector<int>                dirty;   // the tiles with pending changes
+
+public:
+    void reset(int n);
+
+    void add(int row, int col, bool black_hole, int opened = 1) {
+        add_tile(tile(row, col), opened, black_hole);
     }
 
-    void reset(int size) {
+    void add_tile(int tile, int opened, int holes) {
+        if (0 == pending[tile].opened) { // A tile whose changes cancel out may be listed twice, which adds nothing
+            dirty.push_back(tile);
+        }
+        pending[tile].opened += opened;
+        pending[tile].holes += holes;
+        blocks[0][tile].opened += opened;
+        blocks[0][tile].holes += holes;
+    }
+
+    void commit();
+
+    // The tile of the cell
+    int tile(int row, int col) const {
+        return row / VIEW_TILE * side[0] + col / VIEW_TILE;
+    }
+    int levels() const {
+        return (int)side.size();
+    }
+    int blocks_per_side(int level) const {
+        return side[level];
+    }
+    // Board cells on a side of a block of the level
+    int block_cells(int level) const {
+        return VIEW_TILE << level;
+    }
+    const Block& block(int level, int row, int col) const {
+        return blocks[level][row * side[level] + col];
+    }
+};
+
+// Opens the cell 'index' of the board storage and, if it has no black holes nearby, the whole area around it
+// without recursion. An area larger than PARALLEL_OPEN_BUDGET cells is filled by 'threads' threads
+// (0 - all hardware threads) over horizontal stripes. Returns the number of newly opened cells,
+// their Zobrist keys are XORed into 'hash' and they are added to 'tiles'.
+// The parallel fill is for the square topology only, the other topologies fill on one thread.
+// With 'changed', the cells opened are appended to it too, as row * n + col.
+template <class Storage, class Topology = SquareTopology>
+int open_region(Storage& storage, int index, int threads, uint64_t& hash, TileCounts& tiles, std::vector<int>* changed = nullptr);
+
+// The cells that a click into a zero cell opens, precomputed for every region of connected zero cells.
+// The cells of the region r are cells[start[r]]..cells[start[r+1]-1]: its zero cells and the numbered cells around them.
+struct RegionIndex {
+    std::vector<int>      region; // the region of each zero cell of the padded board, -1 for other cells
+    std::vector<int>      start;
+    std::vector<int>      cells;  // padded board indexes
+    std::vector<uint64_t> hash;   // the XOR of the Zobrist keys of the cells of each region
+    // The tiles of the region r (see TileCounts) are tiles[tile_start[r]]..tiles[tile_start[r+1]-1]: a tile and its cells in the region
+    std::vector<int>                 tile_start;
+    std::vector<std::pair<int, int>> tiles;
+
+    int count() const {
+        return start.empty() ? 0 : (int)start.size() - 1;
+    }
+    bool empty() const {
+        return region.empty();
+    }
+    void clear() {
+        region.clear();
+        start.clear();
+        cells.clear();
+        hash.clear();
+        tile_start.clear();
+        tiles.clear();
+    }
+};
+
+// Labels the zero regions of the board storage with a union-find and stores their cells into 'index'
+template <class Storage>
+void build_region_index(const Storage& storage, RegionIndex& index);
+
+// The difficulty of a board, see board_metrics
+struct BoardMetrics {
+    int bbbv = 0;       // 3BV: the fewest clicks that open all safe cells, one for each opening and each isolated cell
+    int openings = 0;   // regions of connected zero cells, a click into one opens it with the numbered cells around it
+    int isolated = 0;   // numbered cells with no zero cell around, no opening reveals them
+    int zero_cells = 0;
+    int safe_cells = 0; // the cells that are not black holes
+};
+
+// Computes the metrics in one pass over the storage with a union-find of the zero cells, from the nearby counts
+template <class Storage, class Topology = SquareTopology>
+BoardMetrics board_metrics(const Storage& storage);
+
+enum class GameState {
+    None,
+    Play,
+    Win,
+    Lost
+};
+
+// The outcome of GameBoard::apply_moves
+struct MovesResult {
+    int       applied = 0; // moves that opened cells, a move into a black hole included
+    int       skipped = 0; // moves outside the board or into cells opened already, e.g. by an earlier move of the batch
+    int       opened = 0;  // cells other than black holes opened by the batch
+    GameState state = GameState::Play;
+};
+
+class GameBoard;
+
+// What one move changed (DoMove, or a whole GameBoard::apply_moves batch), cells as row * size + col.
+// The arrays are valid during BoardObserver::on_move only.
+struct BoardDelta {
+    const int* opened = nullptr; // the cells opened, other than black holes, in the order of the reveal
+    int        opened_count = 0;
+    const int* holes = nullptr;  // the black holes revealed by a loss
+    int        hole_count = 0;
+    GameState  before = GameState::None;
+    GameState  after = GameState::None;
+};
+
+// A subscriber of a board (see GameBoard::subscribe), told what each move changed instead of rescanning the board
+class BoardObserver {
+public:
+    virtual ~BoardObserver() = default;
+    virtual void on_move(const GameBoard& board, const BoardDelta& delta) = 0;
+};
+
+// The common interface of all board implementations, used by the controller and the UI
+class GameBoard {
+protected:
+    GameState  state = GameState::None;
+    uint64_t   hash = 0; // Zobrist hash of the visible board
+    TileCounts tiles;    // the opened cells of each tile, kept up to date by every reveal
+    uint32_t   game = 0; // the number of the game in the telemetry, see GameTelemetry
+
+    // The cells the reveals have opened since the last delta, collected only while the board has observers.
+    // The buffers are shared by all observers and keep their capacity, so a move allocates nothing once they have grown.
+    std::vector<BoardObserver*> observers;
+    std::vector<int>            delta_opened;
+    std::vector<int>            delta_holes;
+
+    void changed(int cell, bool black_hole) {
+        (black_hole ? delta_holes : delta_opened).push_back(cell);
+    }
+    void discard_delta() {
+        delta_opened.clear();
+        delta_holes.clear();
+    }
+
+public:
+    virtual ~GameBoard() = default;
+
+    virtual void setup(int size, const std::vector<int>& holes) = 0;
+
+    virtual int board_size() const = 0;
+    int board_rows() const {
+        return board_size();
+    }
+    int board_cols() const {
+        return board_size();
+    }
+    int board_cells() const {
+        return board_size() * board_size();
+    }
+
+    virtual bool is_valid_cell(int row, int col) const = 0;
+    virtual bool is_opened_cell(int row, int col) const = 0;
+    virtual bool is_black_hole_cell(int row, int col) const = 0;
+    virtual int  black_holes_nearby(int row, int col) const = 0;
+
+    virtual void open_black_holes() = 0;
+    virtual void do_open(int row, int col) = 0;
+    virtual int  hidden_cells() const = 0;
+
+    // Opens the cells (row, col) in their order, like DoMove does one by one, but checks for the win once at the end.
+    // The cells opened already, also by the area of an earlier move of the batch, are skipped;
+    // a black hole ends the game and the batch. On a finished game every move is skipped.
+    virtual MovesResult apply_moves(const std::pair<int, int>* cells, size_t count) = 0;
+    MovesResult apply_moves(const std::vector<std::pair<int, int>>& cells) {
+        return apply_moves(cells.data(), cells.size());
+    }
+    // The number of regions of connected zero cells, -1 if the board has no region index
+    virtual int  zero_regions() const = 0;
+    virtual BoardTopology topology() const = 0;
+    virtual BoardMetrics metrics() const = 0;
+
+    // The black holes and the opened cells as bit masks of (board_cells() + 63) / 64 words each,
+    // the bit i is the cell (i / board_size(), i % board_size()), see GameSnapshot
+    virtual void save_masks(uint64_t* holes, uint64_t* opened) const = 0;
+    // Sets the board up from the masks and the state saved: opens the cells as they are, with no flood fills
+    virtual void restore_masks(int size, const uint64_t* holes, const uint64_t* opened, GameState saved) = 0;
+
+    // The observers are told about the moves until they unsubscribe, they must unsubscribe before they are destroyed.
+    // A new position (setup, restore_masks) is not a delta, the observers read such a board again.
+    void subscribe(BoardObserver* observer) {
+        observers.push_back(observer);
+    }
+    void unsubscribe(BoardObserver* observer) {
+        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+        if (observers.empty()) {
+            discard_delta();
+        }
+    }
+    bool observed() const {
+        return !observers.empty();
+    }
+    // Ends a move that started in the state 'before': gives the changes collected since then to the observers
+    // as one delta. A move that changed nothing is not delivered.
+    void publish(GameState before) {
+        if (observers.empty() || (delta_opened.empty() && delta_holes.empty() && before == state)) {
+            return;
+        }
+        const BoardDelta delta{ delta_opened.data(), (int)delta_opened.size(), delta_holes.data(), (int)delta_holes.size(), before, state };
+        for (auto observer : observers) {
+            observer->on_move(*this, delta);
+        }
+        discard_delta();
+    }
+
+    // Identifies what the player sees, the same position of boards of the same size and layout has the same hash
+    uint64_t visible_hash() const { return hash; }
+    const TileCounts& tile_counts() const { return tiles; }
+    uint32_t game_number() const { return game; }
+    void     set_game_number(uint32_t number) { game = number; }
+
+    // Win/Lost state
+    GameState game_state() const { return state; }
+    bool    IsWin() const { return (GameState::Win == state); }
+    bool    IsGameover() const {
+        return (GameState::Win == state || GameState::Lost == state);
+    }
+
+    // Set game over state
+    void    Win()  { state = GameState::Win; }
+    void    Lost() { state = GameState::Lost; }
+};
+
+// Board storages keep the NxN board inside a one-cell sentinel border, (N+2)x(N+2) cells in total,
+// so every board cell has all 8 neighbours and no bounds checks are needed. offsets_at(index) gives
+// the index offsets of the neighbours of the cell.
+
+// Board storage with the size known at run time
+struct DynamicStorage {
+    static constexpr int default_size = BOARD_SIZE;
+
+    int                   n = 0;
+    int                   stride = 0;
+    std::array<int, 8>    offsets{};
+    std::vector<GameCell> cells;
+
+    int index(int row, int col) const {
+        return (row + 1) * stride + col + 1;
+    }
+
+    // The row and the column of the board cell 'index'
+    std::pair<int, int> position(int index) const {
+        return { index / stride - 1, index % stride - 1 };
+    }
+
+    const std::array<int, 8>& offsets_at(int) const {
+        return offsets;
+    }
+
+    void resize(int size) {
+        n = size;
+        stride = n + 2;
+        offsets = neighbour_offsets(stride);
+        cells.assign(stride * stride, GameCell{ false, false, true, 0 }); // Allocate game board
+        for (auto row = 0; row < n; row++) {
+            for (auto col = 0; col < n; col++) {
+                cells[index(row, col)].border = false;
+            }
+        }
+    }
+};
+
+// Board storage with the size known at compile time
+template <int N>
+struct FixedStorage {
+    static_assert(N > 0, "Board size must be positive");
+    static constexpr int default_size = N;
+    static constexpr int n = N;
+    static constexpr int stride = N + 2;
+    static constexpr std::array<int, 8> offsets = neighbour_offsets(stride);
+
+    std::array<GameCell, stride * stride> cells;
+
+    static constexpr int index(int row, int col) {
+        return (row + 1) * stride + col + 1;
+    }
+
+    static constexpr std::pair<int, int> position(int index) {
+        return { index / stride - 1, index % stride - 1 };
+    }
+
+    static constexpr const std::array<int, 8>& offsets_at(int) {
+        return offsets;
+    }
+
+    void resize(int size) {
+        assert(size == N);
+        (void)size;
+        cells.fill(GameCell{ false, false, true, 0 });
+        for (auto row = 0; row < n; row++) {
+            for (auto col = 0; col < n; col++) {
+                cells[index(row, col)].border = false;
+            }
+        }
+    }
+};
+
+// Board storage with the size known at run time, the padded board is kept in 8x8 tiles, each in Z-order (Morton order).
+// The 3x3 neighbourhood of a cell is mostly in the same tile, so flood fills on large boards stay in few cache lines
+// and pages instead of jumping a whole row for every vertical neighbour.
+struct TiledStorage {
+    static constexpr int default_size = BOARD_SIZE;
+    static constexpr int tile_bits = 3; // see dilate()
+    static constexpr int tile_size = 1 << tile_bits;
+    static constexpr int tile_cells = tile_size * tile_size;
+
+    int                                        n = 0;
+    int                                        tiles = 0; // tiles in a row of tiles
+    std::array<std::array<int, 8>, tile_cells> deltas{};  // neighbour offsets by the position in a tile
+    std::vector<GameCell>                      cells;
+
+    // Spreads the 3 bits of v apart: ..b2 b1 b0 -> b2 0 b1 0 b0
+    static constexpr int dilate(int v) {
+        return (v & 1) | ((v & 2) << 1) | ((v & 4) << 2);
+    }
+
+    // Interleaves the bits of the row and the column in a tile: r2 c2 r1 c1 r0 c0
+    static constexpr int z_order(int row, int col) {
+        return dilate(col) | (dilate(row) << 1);
+    }
+
+    // The inverse of dilate: b2 0 b1 0 b0 -> b2 b1 b0
+    static constexpr int compact(int v) {
+        return (v & 1) | ((v >> 1) & 2) | ((v >> 2) & 4);
+    }
+
+    // The cell of the padded board, its row and column are 1-based for the board cells
+    int padded_index(int prow, int pcol) const {
+        return ((((prow >> tile_bits) * tiles) + (pcol >> tile_bits)) << (2 * tile_bits))
+             | z_order(prow & (tile_size - 1), pcol & (tile_size - 1));
+    }
+
+    int index(int row, int col) const {
+        return padded_index(row + 1, col + 1);
+    }
+
+    std::pair<int, int> position(int index) const {
+        const int tile = index >> (2 * tile_bits),
+                  z = index & (tile_cells - 1);
+        return { (tile / tiles << tile_bits) + compact(z >> 1) - 1, (tile % tiles << tile_bits) + compact(z) - 1 };
+    }
+
+    const std::array<int, 8>& offsets_at(int index) const {
+        return deltas[index & (tile_cells - 1)];
+    }
+
+    void resize(int size) {
         n = size;
-        board.resize(n * n); // Allocate game board
-        for (auto& i : board) {
-            i.opened = false;
-            i.black_hole = false;
-            i.nearby = 0;
+        tiles = (n + 2 + tile_size - 1) / tile_size;
+        // The offsets depend on the position in a tile only, take them in the tile (1, 1)
+        for (auto row = 0; row < tile_size; row++) {
+            for (auto col = 0; col < tile_size; col++) {
+                const int base = padded_index(tile_size + row, tile_size + col);
+                for (auto i = 0u; i < deltas[0].size(); i++) {
+                    deltas[z_order(row, col)][i] = padded_index(tile_size + row + compass_rose[i][1], tile_size + col + compass_rose[i][0]) - base;
+                }
+            }
+        }
+        cells.assign(tiles * tiles * tile_cells, GameCell{ false, false, true, 0 }); // Allocate game board
+        for (auto row = 0; row < n; row++) {
+            for (auto col = 0; col < n; col++) {
+                cells[index(row, col)].border = false;
+            }
+        }
+    }
+};
+
+// A board of the Storage layout with the neighbourhood of the Topology policy
+template <class Storage, class Topology = SquareTopology>
+class BasicGameBoard final : public GameBoard {
+private:
+    Storage storage;
+    RegionIndex regions;
+    int black_holes = 0;
+
+    // Accounts the cell just opened in the hash and in the tile counts
+    void revealed(int index, const GameCell& cell) {
+        hash ^= zobrist_key(index, cell);
+        const auto cell_position = storage.position(index);
+        tiles.add(cell_position.first, cell_position.second, cell.black_hole);
+        if (!observers.empty()) {
+            changed(cell_position.first * storage.n + cell_position.second, cell.black_hole);
+        }
+    }
+
+    void open_cell(int index) {
+        GAME_STATS_OPEN_SCOPE();
+        GAME_STATS_OPENED();
+        storage.cells[index].opened = true;
+        revealed(index, storage.cells[index]);
+
+        if (storage.cells[index].nearby > 0) {
+            return; // Stop opening neighboring cells
+        }
+
+        // Move clockwise from NW to W and open each that is not a black hole
+        for (auto offset : Topology::offsets(storage, index)) {
+            GameCell& cell = storage.cells[index + offset];
+            if (!cell.opened && !cell.border) {
+                if (cell.nearby == 0) {
+                    // Do the same recursively for each cell with zero nearby
+                    open_cell(index + offset);
+                }
+                else {
+                    GAME_STATS_OPENED();
+                    cell.opened = true;
+                    revealed(index + offset, cell);
+                }
+            }
         }
+    }
+
+public:
+    explicit BasicGameBoard(int size = Storage::default_size) {
+        reset(size);
+    }
+
+    void reset(int size) {
+        storage.resize(size);
+        regions.clear();
+        discard_delta();
+        black_holes = 0;
         state = GameState::Play;
+        hash = zobrist_board(size);
+        tiles.reset(size);
     }
 
     void compute_adjacent_black_holes(int row, int col) {
-        board[row * n + col].nearby = 0;
-        // Move clockwise from NW to W and check black holes
-        for (auto i = 0u; i < sizeof(compass_rose) / sizeof(compass_rose[0]); i++) {
-            if (is_valid_cell(row + compass_rose[i][1], col + compass_rose[i][0]) &&
-                is_black_hole_cell(row + compass_rose[i][1], col + compass_rose[i][0])) {
-                board[row * n + col].nearby++;
-            }
+        compute_adjacent_black_holes_at(storage.index(row, col));
+    }
+
+    void compute_adjacent_black_holes_at(int index) {
+        GAME_STATS_ADJACENT();
+        int nearby = 0;
+        // Sentinel cells are never black holes, so the sum needs no bounds checks
+#pragma GCC unroll 8
+        for (auto offset : Topology::offsets(storage, index)) {
+            nearby += storage.cells[index + offset].black_hole;
         }
+        storage.cells[index].nearby = nearby;
     }
 
     void compute_adjacent_black_holes() {
-        for (auto row = 0; row < board_rows(); row++) {
-            for (auto col = 0; col < board_cols(); col++) {
-                compute_adjacent_black_holes(row, col);
+        GAME_STATS_TIMER(AdjacentBlackHoles);
+        // In the storage order, which is the most cache friendly for any layout
+        for (auto i = 0; i < (int)storage.cells.size(); i++) {
+            if (!storage.cells[i].border) {
+                compute_adjacent_black_holes_at(i);
             }
         }
     }
 
     void set_black_holes(const std::vector<int>& holes) {
         for (auto i : holes) {
-            assert(0 <= i && i < n* n);
-            board[i].black_hole = true;
+            assert(0 <= i && i < board_cells());
+            GameCell& cell = storage.cells[storage.index(i / storage.n, i % storage.n)];
+            black_holes += !cell.black_hole;
+            cell.black_hole = true;
         }
         compute_adjacent_black_holes();
     }
 
-    void setup(int size, const std::vector<int>& holes) {
+    void setup(int size, const std::vector<int>& holes) override {
+        GAME_STATS_TIMER(Setup);
         reset(size);
         set_black_holes(holes);
-        compute_adjacent_black_holes();
+        if (is_square_topology<Topology> && GameSettings::getSettings().get_region_index()) {
+            build_region_index(storage, regions);
+        }
     }
 
-    int board_size() const {
-        return n;
-    }
-    int board_rows() const {
-        return board_size();
-    }
-    int board_cols() const {
-        return board_size();
+    int board_size() const override {
+        return storage.n;
     }
 
-    int board_cells() const {
-        return n * n;
+    bool is_valid_cell(int row, int col) const override {
+        return (row >= 0 && col >= 0 && row < storage.n && col < storage.n);
     }
 
-    bool is_valid_cell(int row, int col) const {
-        return (row >= 0 && col >= 0 && row < n && col < n);
+    bool is_opened_cell(int row, int col) const override {
+        assert(is_valid_cell(row, col));
+        return storage.cells[storage.index(row, col)].opened;
     }
 
-    bool is_opened_cell(int row, int col) const {
+    bool is_black_hole_cell(int row, int col) const override {
         assert(is_valid_cell(row, col));
-        return board[row * n + col].opened;
+        return storage.cells[storage.index(row, col)].black_hole;
     }
 
-    bool is_black_hole_cell(int row, int col) const {
+    int black_holes_nearby(int row, int col) const override {
         assert(is_valid_cell(row, col));
-        return board[row * n + col].black_hole;
+        return storage.cells[storage.index(row, col)].nearby;
     }
 
-    int black_holes_nearby(int row, int col) const {
+    void open_black_holes() override {
+        for (auto i = 0; i < (int)storage.cells.size(); i++) {
+            if (storage.cells[i].black_hole && !storage.cells[i].opened) {
+                storage.cells[i].opened = true;
+                revealed(i, storage.cells[i]);
+            }
+        }
+        tiles.commit();
+    }
+
+    void do_open(int row, int col) override {
         assert(is_valid_cell(row, col));
-        return board[row * n + col].nearby;
+        const int index = storage.index(row, col);
+        if (is_square_topology<Topology> && !regions.empty() && regions.region[index] >= 0) {
+            // A lookup: open the precomputed cells of the region
+            GAME_STATS_OPEN_SCOPE();
+            const int r = regions.region[index];
+            hash ^= regions.hash[r];
+            for (auto t = regions.tile_start[r]; t < regions.tile_start[r + 1]; t++) {
+                tiles.add_tile(regions.tiles[t].first, regions.tiles[t].second, 0);
+            }
+            for (auto i = regions.start[r]; i < regions.start[r + 1]; i++) {
+                GameCell& cell = storage.cells[regions.cells[i]];
+                if (cell.opened) { // A numbered cell opened before, its key is in the hash and its tile count already
+                    hash ^= zobrist_key(regions.cells[i], cell);
+                    const auto cell_position = storage.position(regions.cells[i]);
+                    tiles.add(cell_position.first, cell_position.second, false, -1);
+                }
+                else if (!observers.empty()) {
+                    const auto cell_position = storage.position(regions.cells[i]);
+                    changed(cell_position.first * storage.n + cell_position.second, false);
+                }
+                cell.opened = true;
+            }
+            tiles.commit();
+            GAME_STATS_OPENED_CELLS(regions.start[r + 1] - regions.start[r]);
+            return;
+        }
+        if (board_cells() >= LARGE_BOARD_CELLS) {
+            GAME_STATS_OPEN_SCOPE();
+            const int opened = open_region<Storage, Topology>(storage, index, GameSettings::getSettings().get_open_threads(), hash, tiles,
+                                                              observers.empty() ? nullptr : &delta_opened);
+            tiles.commit();
+            GAME_STATS_OPENED_CELLS(opened);
+            (void)opened;
+            return;
+        }
+        open_cell(index);
+        tiles.commit();
     }
 
-    // Win/Lost state
-    bool    IsWin() const { return (GameState::Win == state); }
-    bool    IsGameover() const {
-        return (GameState::Win == state || GameState::Lost == state);
+    // The tile counts know the cells opened, so no scan of the board is needed
+    int hidden_cells() const override {
+        GAME_STATS_TIMER(HiddenCells);
+        const TileCounts::Block& all = tiles.block(tiles.levels() - 1, 0, 0);
+        return (board_cells() - (all.opened - all.holes) - black_holes);
     }
 
-    void open_black_holes() {
-        for (auto& i : board) {
-            if (i.black_hole) {
-                i.opened = true;
+    using GameBoard::apply_moves;
+    MovesResult apply_moves(const std::pair<int, int>* cells, size_t count) override {
+        MovesResult result;
+        if (GameState::Play != state) { // A finished game takes no moves
+            result.skipped = (int)count;
+            result.state = state;
+            return result;
+        }
+        const GameState before = state;
+        const int hidden = hidden_cells();
+        for (size_t i = 0; i < count; i++) {
+            const int row = cells[i].first,
+                      col = cells[i].second;
+            if (!is_valid_cell(row, col) || storage.cells[storage.index(row, col)].opened) {
+                result.skipped++;
+                continue;
+            }
+            result.applied++;
+            if (storage.cells[storage.index(row, col)].black_hole) {
+                result.opened = hidden - hidden_cells();
+                open_black_holes();
+                Lost();
+                result.state = state;
+                publish(before);
+                return result;
             }
+            do_open(row, col);
         }
+        result.opened = hidden - hidden_cells();
+        if (0 == hidden_cells()) {
+            Win();
+        }
+        result.state = state;
+        publish(before);
+        return result;
     }
 
-    void do_open(int row, int col) {
-        board[row * n + col].opened = true;
+    int zero_regions() const override {
+        return regions.empty() ? -1 : regions.count();
+    }
 
-        if (board[row * n + col].nearby > 0) {
-            return; // Stop opening neighboring cells
-        }
+    BoardTopology topology() const override {
+        return Topology::kind;
+    }
 
-        // Move clockwise from NW to W and open each that is not a black hole
-        for (auto i = 0u; i < sizeof(compass_rose) / sizeof(compass_rose[0]); i++) {
-            int crow = row + compass_rose[i][1],
-                ccol = col + compass_rose[i][0];
-            if (is_valid_cell(crow, ccol)) {
-                if ( !board[crow * n + ccol].opened ) {
-                    if ( board[crow * n + ccol].nearby == 0 ) {
-                        // Do the same recursively for each cell with zero nearby
-                        do_open(crow, ccol);
-                    }
-                    else {
-                        board[crow * n + ccol].opened = true;
-                    }
-                }
+    BoardMetrics metrics() const override {
+        return board_metrics<Storage, Topology>(storage);
+    }
+
+    void save_masks(uint64_t* holes, uint64_t* opened) const override {
+        const int words = (board_cells() + 63) / 64;
+        std::fill(holes, holes + words, 0);
+        std::fill(opened, opened + words, 0);
+        for (auto row = 0, i = 0; row < storage.n; row++) {
+            for (auto col = 0; col < storage.n; col++, i++) {
+                const GameCell& cell = storage.cells[storage.index(row, col)];
+                holes[i >> 6] |= (uint64_t)cell.black_hole << (i & 63);
+                opened[i >> 6] |= (uint64_t)cell.opened << (i & 63);
             }
         }
     }
 
-    int hidden_cells() const {
-        int opened = 0,
-            black_holes = 0;
-        for (const auto& cell : board) {
-            if (cell.black_hole) black_holes++;
-            else if (cell.opened) opened++;
+    void restore_masks(int size, const uint64_t* holes, const uint64_t* opened, GameState saved) override {
+        reset(size);
+        const int words = (board_cells() + 63) / 64;
+        // Visits the set bits only
+        for (auto w = 0; w < words; w++) {
+            for (uint64_t bits = holes[w]; bits; bits &= bits - 1) {
+                const int i = w * 64 + __builtin_ctzll(bits);
+                storage.cells[storage.index(i / storage.n, i % storage.n)].black_hole = true;
+                black_holes++;
+            }
         }
-        return (n*n - opened - black_holes);
+        compute_adjacent_black_holes();
+        for (auto w = 0; w < words; w++) {
+            for (uint64_t bits = opened[w]; bits; bits &= bits - 1) {
+                const int i = w * 64 + __builtin_ctzll(bits),
+                          index = storage.index(i / storage.n, i % storage.n);
+                storage.cells[index].opened = true;
+                revealed(index, storage.cells[index]);
+            }
+        }
+        tiles.commit();
+        discard_delta();
+        if (is_square_topology<Topology> && GameSettings::getSettings().get_region_index()) {
+            build_region_index(storage, regions);
+        }
+        state = saved;
     }
+};
 
-    // Set game over state
-    void    Win()  { state = GameState::Win; }
-    void    Lost() { state = GameState::Lost; }
+// Board of any size
+using DynamicGameBoard = BasicGameBoard<DynamicStorage>;
 
-};
+// Board specialized for the size N
+template <int N>
+using FixedGameBoard = BasicGameBoard<FixedStorage<N>>;
+
+// Board of any size in the tiled layout
+using TiledGameBoard = BasicGameBoard<TiledStorage>;
+
+// Board of any size with another neighbourhood than the square one
+template <class Topology>
+using TopologyGameBoard = BasicGameBoard<DynamicStorage, Topology>;
+
+// Creates the board for the size: a FixedGameBoard<size> for MIN_BOARD_SIZE..MAX_BOARD_SIZE,
+// otherwise (e.g. a larger board read from a file) a DynamicGameBoard, or a TiledGameBoard with the tiled layout on.
+// The other topologies are a TopologyGameBoard of any size.
+std::unique_ptr<GameBoard> make_game_board(int size, BoardTopology topology = BoardTopology::Square);
 
 
 #endif
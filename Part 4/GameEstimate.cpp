@@ -0,0 +1,618 @@
+//
+// GameEstimate.cpp
+//
+// Probabilities of black holes in the closed cells. Every layout of the black holes consistent with the view is
+// equally likely. The numbers split the closed cells next to them (the frontier) into components that share no number,
+// the layouts of each component are counted by the number of holes in them: exactly while the enumeration fits into
+// the budget, by a Markov chain Monte Carlo estimate on all threads beyond it. The components meet only in the total
+// of the black holes: the layouts with k holes in the frontier count C(interior, holes left - k) times, once for each
+// way to place the other holes into the cells away from the numbers.
+//
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include "GameHint.h"
+#include "GameData.h"
+
+#define ESTIMATE_COMPONENT_SHARE 16  // a component may take this share of the exact budget before it is sampled instead
+#define SAMPLE_BATCHES           8   // batches of the sampling, their spread gives the confidence intervals
+#define SAMPLE_BETA              3.0 // a layout with e holes missing or extra at the numbers weighs exp(-beta * e)
+#define SAMPLE_BURN_IN           100 // sweeps of a chain before it is sampled
+#define SAMPLE_SWEEPS            4   // sweeps of a chain between the samples
+
+namespace GameHint {
+
+    namespace {
+
+        // The closed cells not known to be black holes: the frontier cells are next to numbers, the interior cells are not
+        struct Frontier {
+            std::vector<int>              cells;       // view indexes of the frontier cells
+            std::vector<int>              interior;    // view indexes of the interior cells
+            int                           holes = 0;   // black holes among the frontier and interior cells
+            std::vector<int>              need;        // the black holes of each number among its frontier cells
+            std::vector<std::vector<int>> members;     // the frontier cells of each number
+            std::vector<std::vector<int>> numbers;     // the numbers next to each frontier cell
+        };
+
+        // Returns false if the view contradicts the known holes
+        bool make_frontier(const BoardView& view, const std::vector<std::pair<int, int>>& holes, Frontier& f) {
+            const int n = view.n;
+            std::vector<char> known(n * n, 0);
+            for (const auto& h : holes) {
+                known[h.first * n + h.second] = 1;
+            }
+            std::vector<int> position(n * n, -1); // of the cell in f.cells
+            for (auto row = 0; row < n; row++) {
+                for (auto col = 0; col < n; col++) {
+                    const int number = view.cells[row * n + col];
+                    if (number <= 0) {
+                        continue;
+                    }
+                    int need = number;
+                    std::vector<int> members;
+                    for (const auto& d : compass_rose) {
+                        const int r = row + d[1], k = col + d[0];
+                        if (r < 0 || k < 0 || r >= n || k >= n || view.cells[r * n + k] >= 0) {
+                            continue;
+                        }
+                        const int i = r * n + k;
+                        if (known[i]) {
+                            need--;
+                            continue;
+                        }
+                        if (position[i] < 0) {
+                            position[i] = (int)f.cells.size();
+                            f.cells.push_back(i);
+                            f.numbers.emplace_back();
+                        }
+                        members.push_back(position[i]);
+                    }
+                    if (need < 0 || need > (int)members.size()) {
+                        return false;
+                    }
+                    if (!members.empty()) {
+                        for (auto m : members) {
+                            f.numbers[m].push_back((int)f.need.size());
+                        }
+                        f.need.push_back(need);
+                        f.members.push_back(std::move(members));
+                    }
+                }
+            }
+            for (auto i = 0; i < n * n; i++) {
+                if (view.cells[i] < 0 && !known[i] && position[i] < 0) {
+                    f.interior.push_back(i);
+                }
+            }
+            f.holes = view.black_holes - (int)holes.size();
+            return f.holes >= 0 && f.holes <= (int)(f.cells.size() + f.interior.size());
+        }
+
+        double log_binomial(int n, int k) {
+            return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+        }
+
+        // Counts of layouts by the number of black holes in them, scaled by exp(log_scale) to stay in the range of doubles
+        struct Polynomial {
+            std::vector<double> c;
+            double              log_scale = 0;
+        };
+
+        // The product of the polynomials, the terms above 'degree' dropped
+        Polynomial multiply(const Polynomial& a, const Polynomial& b, int degree) {
+            Polynomial p;
+            p.c.assign(std::min<size_t>(a.c.size() + b.c.size() - 1, degree + 1), 0);
+            for (size_t i = 0; i < a.c.size() && i < p.c.size(); i++) {
+                for (size_t j = 0; j < b.c.size() && i + j < p.c.size(); j++) {
+                    p.c[i + j] += a.c[i] * b.c[j];
+                }
+            }
+            const double top = *std::max_element(p.c.begin(), p.c.end());
+            p.log_scale = a.log_scale + b.log_scale;
+            if (top > 0) {
+                for (auto& x : p.c) {
+                    x /= top;
+                }
+                p.log_scale += std::log(top);
+            }
+            return p;
+        }
+
+        // The frontier cells connected by numbers, their layouts counted by the number of black holes in them.
+        // Sampled counts are scaled down by an unknown factor, which does not matter: only their ratios are used.
+        struct Component {
+            std::vector<int>                 order;      // frontier cells, in the breadth-first order of their numbers
+            std::vector<double>              layouts;    // per number of holes
+            std::vector<std::vector<double>> cell_holes; // per number of holes, per cell of 'order'
+            bool                             sampled = false;
+
+            void clear() {
+                layouts.assign(order.size() + 1, 0);
+                cell_holes.assign(order.size() + 1, {});
+            }
+
+            // Counts the layout, 'hole' is indexed as 'order'
+            void add(int k, const std::vector<char>& hole) {
+                if (cell_holes[k].empty()) {
+                    cell_holes[k].assign(order.size(), 0);
+                }
+                layouts[k]++;
+                for (size_t i = 0; i < order.size(); i++) {
+                    cell_holes[k][i] += hole[i];
+                }
+            }
+
+            void merge(const Component& other) {
+                for (size_t k = 0; k < layouts.size(); k++) {
+                    layouts[k] += other.layouts[k];
+                    if (!other.cell_holes[k].empty()) {
+                        if (cell_holes[k].empty()) {
+                            cell_holes[k].assign(order.size(), 0);
+                        }
+                        for (size_t i = 0; i < order.size(); i++) {
+                            cell_holes[k][i] += other.cell_holes[k][i];
+                        }
+                    }
+                }
+            }
+        };
+
+        std::vector<Component> split(const Frontier& f) {
+            std::vector<Component> components;
+            std::vector<char> queued(f.cells.size(), 0);
+            for (auto first = 0; first < (int)f.cells.size(); first++) {
+                if (queued[first]) {
+                    continue;
+                }
+                Component component;
+                queued[first] = 1;
+                component.order.push_back(first);
+                for (size_t head = 0; head < component.order.size(); head++) {
+                    for (auto c : f.numbers[component.order[head]]) {
+                        for (auto y : f.members[c]) {
+                            if (!queued[y]) {
+                                queued[y] = 1;
+                                component.order.push_back(y);
+                            }
+                        }
+                    }
+                }
+                component.clear();
+                components.push_back(std::move(component));
+            }
+            return components;
+        }
+
+        // Depth-first enumeration of the layouts of a component, the cells in their breadth-first order,
+        // so that each number is complete (and checked) soon after its first cell
+        class Enumeration {
+            const Frontier&          f;
+            const std::atomic<bool>& cancelled;
+            uint64_t                 steps = 0,
+                                     limit = 0;
+            bool                     aborted = false;
+            std::vector<int>         need, free; // per number: black holes still to place, cells not assigned yet
+            std::vector<char>        hole;       // per cell of the component
+            int                      k = 0;      // black holes placed
+
+            void visit(Component& component, int depth) {
+                if (aborted || ++steps > limit || (0 == (steps & 0xFFF) && cancelled.load(std::memory_order_relaxed))) {
+                    aborted = true;
+                    return;
+                }
+                if (depth == (int)component.order.size()) {
+                    component.add(k, hole);
+                    return;
+                }
+                const int x = component.order[depth];
+                bool can_hole = k < f.holes,
+                     can_safe = true;
+                for (auto c : f.numbers[x]) {
+                    can_hole = can_hole && need[c] > 0;
+                    can_safe = can_safe && free[c] - 1 >= need[c];
+                }
+                for (auto c : f.numbers[x]) {
+                    free[c]--;
+                }
+                if (can_hole) {
+                    for (auto c : f.numbers[x]) {
+                        need[c]--;
+                    }
+                    hole[depth] = 1;
+                    k++;
+                    visit(component, depth + 1);
+                    k--;
+                    hole[depth] = 0;
+                    for (auto c : f.numbers[x]) {
+                        need[c]++;
+                    }
+                }
+                if (can_safe) {
+                    visit(component, depth + 1);
+                }
+                for (auto c : f.numbers[x]) {
+                    free[c]++;
+                }
+            }
+
+        public:
+            Enumeration(const Frontier& f, const std::atomic<bool>& cancelled)
+                : f(f), cancelled(cancelled), need(f.need), free(f.need.size()) {
+                for (size_t c = 0; c < f.members.size(); c++) {
+                    free[c] = (int)f.members[c].size();
+                }
+            }
+
+            // Returns false if the component takes more than 'budget' steps, its counts are incomplete then
+            bool count(Component& component, uint64_t budget) {
+                component.clear();
+                hole.assign(component.order.size(), 0);
+                steps = 0;
+                limit = budget;
+                aborted = false;
+                visit(component, 0);
+                return !aborted;
+            }
+
+            uint64_t steps_taken() const {
+                return steps;
+            }
+        };
+
+        /*
+            Function: combine
+            Parameters:
+                f - the frontier
+                components - the counts of the layouts of its components
+                probability - receives the probabilities of the frontier and interior cells, indexed as the view
+
+            Description: for each component the counts of all the other components are multiplied into one polynomial
+            (the products of the components before and after it), which gives the weight of its layouts with k holes:
+            the sum of the layouts of the others with r holes times C(interior, holes - k - r).
+
+            Returns: false if no layout is consistent with the view
+        */
+        bool combine(const Frontier& f, const std::vector<Component>& components, std::vector<double>& probability) {
+            const int interior = (int)f.interior.size();
+            const int degree = std::min(f.holes, (int)f.cells.size());
+            std::vector<double> log_weight(degree + 1, -INFINITY);
+            double top = -INFINITY;
+            for (auto k = std::max(0, f.holes - interior); k <= degree; k++) {
+                log_weight[k] = log_binomial(interior, f.holes - k);
+                top = std::max(top, log_weight[k]);
+            }
+            if (top == -INFINITY) {
+                return false;
+            }
+
+            const size_t count = components.size();
+            std::vector<Polynomial> before(count + 1), after(count + 1);
+            before[0].c.assign(1, 1.0);
+            after[count].c.assign(1, 1.0);
+            for (size_t j = 0; j < count; j++) {
+                Polynomial p;
+                p.c = components[j].layouts;
+                before[j + 1] = multiply(before[j], p, degree);
+                p.c = components[count - 1 - j].layouts;
+                after[count - 1 - j] = multiply(p, after[count - j], degree);
+            }
+
+            // The weight of the layouts of the polynomial shifted by 'shift' holes, and their holes left for the interior
+            auto weighted = [&](const Polynomial& p, int shift, double& interior_holes) {
+                double sum = 0;
+                interior_holes = 0;
+                for (size_t r = 0; r < p.c.size() && shift + (int)r <= degree; r++) {
+                    const double w = p.c[r] * std::exp(log_weight[shift + r] - top);
+                    sum += w;
+                    interior_holes += w * (f.holes - shift - (int)r);
+                }
+                return sum;
+            };
+
+            for (size_t j = 0; j < count; j++) {
+                const Component& component = components[j];
+                const Polynomial others = multiply(before[j], after[j + 1], degree);
+                std::vector<double> holes(component.order.size(), 0);
+                double total = 0, unused;
+                for (size_t k = 0; k < component.layouts.size() && (int)k <= degree; k++) {
+                    if (0 == component.layouts[k]) {
+                        continue;
+                    }
+                    const double g = weighted(others, (int)k, unused);
+                    total += component.layouts[k] * g;
+                    for (size_t i = 0; i < component.order.size(); i++) {
+                        holes[i] += component.cell_holes[k][i] * g;
+                    }
+                }
+                if (!(total > 0)) {
+                    return false;
+                }
+                for (size_t i = 0; i < component.order.size(); i++) {
+                    probability[f.cells[component.order[i]]] = holes[i] / total;
+                }
+            }
+
+            double interior_holes;
+            const double total = weighted(before[count], 0, interior_holes);
+            if (!(total > 0)) {
+                return false;
+            }
+            for (auto i : f.interior) {
+                probability[i] = interior_holes / total / interior;
+            }
+            return true;
+        }
+
+        /*
+            Class: Chain
+
+            Description: a Metropolis chain over the layouts of one component. A layout with e holes missing or extra
+            at the numbers weighs exp(-SAMPLE_BETA * e). The steps toggle a cell, or swap two cells: either any two
+            or two next to the same number (both choices are symmetric, so the swaps need no correction).
+            Only the layouts that meet all numbers (e == 0) are counted, they all weigh the same, so their counts
+            by the number of holes are proportional to the exact counts.
+        */
+        class Chain {
+            const Frontier&               f;
+            const Component&              component;
+            std::vector<std::vector<int>> related;   // the cells that share a number with each cell, indexes of 'order'
+            std::vector<char>             hole;      // indexed as 'order'
+            std::vector<int>              count;     // black holes at each number
+            int                           k = 0,     // black holes in the component
+                                          unmet = 0; // black holes missing or extra at the numbers
+
+            // Toggles the cell, returns the change of the unmet holes
+            int toggle(int i) {
+                const int d = hole[i] ? -1 : 1;
+                int change = 0;
+                for (auto c : f.numbers[component.order[i]]) {
+                    change += std::abs(count[c] + d - f.need[c]) - std::abs(count[c] - f.need[c]);
+                    count[c] += d;
+                }
+                hole[i] ^= 1;
+                k += d;
+                return change;
+            }
+
+        public:
+            Chain(const Frontier& f, const Component& component)
+                : f(f), component(component), related(component.order.size()), hole(component.order.size(), 0), count(f.need.size(), 0) {
+                std::vector<int> local(f.cells.size(), -1);
+                for (size_t i = 0; i < component.order.size(); i++) {
+                    local[component.order[i]] = (int)i;
+                }
+                std::vector<char> counted(f.need.size(), 0);
+                for (size_t i = 0; i < component.order.size(); i++) {
+                    for (auto c : f.numbers[component.order[i]]) {
+                        if (!counted[c]) {
+                            counted[c] = 1;
+                            unmet += f.need[c];
+                        }
+                        for (auto y : f.members[c]) {
+                            const int j = local[y];
+                            if (j != (int)i && std::find(related[i].begin(), related[i].end(), j) == related[i].end()) {
+                                related[i].push_back(j);
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Starts over from a random layout, so that the batches do not all stay with the same states
+            void restart(std::mt19937_64& rgen) {
+                for (size_t i = 0; i < hole.size(); i++) {
+                    if ((rgen() & 1) != (uint64_t)hole[i] && (hole[i] || k < f.holes)) {
+                        unmet += toggle((int)i);
+                    }
+                }
+            }
+
+            void step(std::mt19937_64& rgen) {
+                const int cells = (int)hole.size();
+                const int i = (int)(rgen() % cells);
+                const unsigned move = (unsigned)(rgen() % 4);
+                int j = -1;
+                if (move >= 2) { // Swap i with a cell of the other state
+                    j = (3 == move && !related[i].empty()) ? related[i][rgen() % related[i].size()] : (int)(rgen() % cells);
+                    if (hole[i] == hole[j]) {
+                        return;
+                    }
+                }
+                else if (!hole[i] && k >= f.holes) {
+                    return;
+                }
+                const int change = toggle(i) + (j >= 0 ? toggle(j) : 0);
+                if (change > 0 && std::generate_canonical<double, 32>(rgen) >= std::exp(-SAMPLE_BETA * change)) {
+                    if (j >= 0) {
+                        toggle(j);
+                    }
+                    toggle(i);
+                    return;
+                }
+                unmet += change;
+            }
+
+            void sweep(std::mt19937_64& rgen, int sweeps) {
+                for (auto s = (size_t)sweeps * hole.size(); s > 0; s--) {
+                    step(rgen);
+                }
+            }
+
+            // Counts the layout if it meets all numbers
+            void sample(Component& counts) const {
+                if (0 == unmet) {
+                    counts.add(k, hole);
+                }
+            }
+        };
+
+        /*
+            Function: sample
+            Parameters:
+                f - the frontier
+                components - the components; the ones marked 'sampled' receive the counts of the samples
+                cancelled - checked between the sweeps
+                limits - the time budget and the threads
+                result - receives the probabilities and their confidence intervals
+
+            Description: each thread runs its own chain for every sampled component with its own random stream,
+            seeded from the number of the call and of the thread.
+            The budget is split into SAMPLE_BATCHES time slices: the counts of each slice (of all threads) give
+            one estimate of the probabilities, the spread of these estimates gives the confidence intervals
+            and all the counts together give the probabilities.
+
+            Returns: false if cancelled, or if some component has no layout meeting its numbers in some slice
+        */
+        bool sample(const Frontier& f, std::vector<Component>& components, const std::atomic<bool>& cancelled,
+                    const EstimateLimits& limits, Estimate& result) {
+            const int threads = limits.threads > 0 ? limits.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+            std::vector<int> sampled;
+            for (size_t j = 0; j < components.size(); j++) {
+                if (components[j].sampled) {
+                    sampled.push_back((int)j);
+                }
+            }
+
+            // Each call samples with other random streams, so the estimates of positions are independent
+            static std::atomic<uint64_t> calls{ 0 };
+            const uint64_t seed = zobrist_mix(calls.fetch_add(1, std::memory_order_relaxed) + 1);
+            const auto start = std::chrono::steady_clock::now();
+            // The counts of each thread in each slice, for each sampled component
+            std::vector<std::vector<std::vector<Component>>> counts(threads,
+                std::vector<std::vector<Component>>(SAMPLE_BATCHES, std::vector<Component>(sampled.size())));
+            std::vector<std::thread> pool;
+            for (auto t = 0; t < threads; t++) {
+                pool.emplace_back([&, t] {
+                    std::mt19937_64 rgen(zobrist_mix(seed ^ (uint64_t)(t + 1)));
+                    std::vector<Chain> chains;
+                    for (auto s : sampled) {
+                        chains.emplace_back(f, components[s]);
+                    }
+                    for (auto b = 0; b < SAMPLE_BATCHES; b++) {
+                        const auto deadline = start + std::chrono::milliseconds(limits.sample_ms) * (b + 1) / SAMPLE_BATCHES;
+                        for (size_t s = 0; s < sampled.size(); s++) {
+                            chains[s].restart(rgen);
+                            chains[s].sweep(rgen, SAMPLE_BURN_IN);
+                            counts[t][b][s].order = components[sampled[s]].order;
+                            counts[t][b][s].clear();
+                        }
+                        while (!cancelled.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < deadline) {
+                            for (size_t s = 0; s < sampled.size(); s++) {
+                                chains[s].sweep(rgen, SAMPLE_SWEEPS);
+                                chains[s].sample(counts[t][b][s]);
+                            }
+                        }
+                    }
+                });
+            }
+            for (auto& t : pool) {
+                t.join();
+            }
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return false;
+            }
+
+            // The estimate of each slice, then of all of them
+            const size_t cells = result.probability.size();
+            std::vector<double> sum(cells, 0), sum_of_squares(cells, 0);
+            std::vector<Component> all(components);
+            for (auto s : sampled) {
+                all[s].clear();
+            }
+            int slices = 0;
+            for (auto b = 0; b < SAMPLE_BATCHES; b++) {
+                std::vector<Component> slice(components);
+                for (size_t s = 0; s < sampled.size(); s++) {
+                    slice[sampled[s]].clear();
+                    for (auto t = 0; t < threads; t++) {
+                        slice[sampled[s]].merge(counts[t][b][s]);
+                        all[sampled[s]].merge(counts[t][b][s]);
+                        result.layouts += (uint64_t)std::accumulate(counts[t][b][s].layouts.begin(), counts[t][b][s].layouts.end(), 0.0);
+                    }
+                }
+                std::vector<double> probability(result.probability);
+                if (!combine(f, slice, probability)) {
+                    continue;
+                }
+                slices++;
+                for (size_t i = 0; i < cells; i++) {
+                    if (probability[i] >= 0) {
+                        sum[i] += probability[i];
+                        sum_of_squares[i] += probability[i] * probability[i];
+                    }
+                }
+            }
+            if (slices < 2 || !combine(f, all, result.probability)) {
+                return false;
+            }
+            // Student's t for the 95% interval of the mean of 2..8 slices
+            static const double t95[SAMPLE_BATCHES + 1] = { 0, 0, 12.71, 4.30, 3.18, 2.78, 2.57, 2.45, 2.36 };
+            for (size_t i = 0; i < cells; i++) {
+                if (result.probability[i] >= 0) {
+                    const double mean = sum[i] / slices;
+                    const double variance = std::max(0.0, (sum_of_squares[i] / slices - mean * mean) * slices / (slices - 1));
+                    result.error[i] = t95[slices] * std::sqrt(variance / slices);
+                }
+            }
+            return true;
+        }
+
+    } // namespace
+
+    /*
+        Function: estimate
+        Parameters:
+            view - the visible position
+            holes - the cells known to be black holes
+            cancelled - checked while counting or sampling
+            limits - the budget: the steps of the exact enumeration, then the time and threads of the sampling
+            result - receives the probabilities
+
+        Description: counts the layouts of each component of the frontier exactly. A component that takes more than
+        1/ESTIMATE_COMPONENT_SHARE of limits.exact_nodes steps, or comes after the budget is spent, is sampled instead
+        for limits.sample_ms milliseconds on limits.threads threads.
+
+        Returns: false if cancelled, if the view has no consistent layout, or if the sampling is off or fails in time
+    */
+    bool estimate(const BoardView& view, const std::vector<std::pair<int, int>>& holes, const std::atomic<bool>& cancelled,
+                  const EstimateLimits& limits, Estimate& result) {
+        result = Estimate();
+        result.probability.assign(view.n * view.n, -1.0);
+        result.error.assign(view.n * view.n, 0.0);
+        Frontier f;
+        if (!make_frontier(view, holes, f)) {
+            return false;
+        }
+        std::vector<Component> components = split(f);
+        Enumeration enumeration(f, cancelled);
+        uint64_t budget = limits.exact_nodes;
+        bool sampling = false;
+        for (auto& component : components) {
+            const uint64_t share = std::min(budget, std::max<uint64_t>(limits.exact_nodes / ESTIMATE_COMPONENT_SHARE, 1));
+            if (enumeration.count(component, share)) {
+                result.layouts += (uint64_t)std::accumulate(component.layouts.begin(), component.layouts.end(), 0.0);
+            }
+            else {
+                component.sampled = sampling = true;
+            }
+            budget -= std::min(budget, enumeration.steps_taken());
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return false;
+            }
+        }
+        if (!sampling) {
+            result.exact = true;
+            return combine(f, components, result.probability);
+        }
+        if (limits.sample_ms <= 0) {
+            return false;
+        }
+        result.layouts = 0;
+        return sample(f, components, cancelled, limits, result);
+    }
+
+} // namespace GameHint
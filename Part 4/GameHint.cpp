@@ -0,0 +1,361 @@
+//
+// GameHint.cpp
+//
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <tuple>
+
+#include "GameHint.h"
+#include "GameData.h"
+
+namespace GameHint {
+
+    namespace {
+
+        enum class Known : signed char {
+            Unknown,
+            Safe,
+            Hole
+        };
+
+        // An opened numbered cell: 'holes' black holes are among its 'cells' closed neighbours still unknown
+        struct Constraint {
+            std::vector<int> cells;
+            int              holes;
+        };
+
+        // Updates the constraints with the cells found, drops the solved ones. Returns true if any cell was found.
+        bool apply_single_rules(std::vector<Constraint>& constraints, std::vector<Known>& known) {
+            bool found = false;
+            for (auto& c : constraints) {
+                auto unknown = std::remove_if(c.cells.begin(), c.cells.end(), [&](int i) {
+                    if (Known::Hole == known[i]) {
+                        c.holes--;
+                    }
+                    return Known::Unknown != known[i];
+                });
+                c.cells.erase(unknown, c.cells.end());
+                if (c.cells.empty()) {
+                    continue;
+                }
+                if (0 == c.holes || (int)c.cells.size() == c.holes) {
+                    for (auto i : c.cells) {
+                        known[i] = c.holes ? Known::Hole : Known::Safe;
+                    }
+                    c.holes = 0;
+                    c.cells.clear();
+                    found = true;
+                }
+            }
+            constraints.erase(std::remove_if(constraints.begin(), constraints.end(),
+                [](const Constraint& c) { return c.cells.empty(); }), constraints.end());
+            return found;
+        }
+
+        // If the cells of a are a subset of the cells of b, the other cells of b have b.holes - a.holes black holes
+        bool apply_subset_rule(const Constraint& a, const Constraint& b, std::vector<Known>& known) {
+            if (a.cells.size() >= b.cells.size() || !std::includes(b.cells.begin(), b.cells.end(), a.cells.begin(), a.cells.end())) {
+                return false;
+            }
+            std::vector<int> rest;
+            std::set_difference(b.cells.begin(), b.cells.end(), a.cells.begin(), a.cells.end(), std::back_inserter(rest));
+            const int holes = b.holes - a.holes;
+            if (0 != holes && (int)rest.size() != holes) {
+                return false;
+            }
+            for (auto i : rest) {
+                known[i] = holes ? Known::Hole : Known::Safe;
+            }
+            return true;
+        }
+
+    } // namespace
+
+    BoardView snapshot(const GameBoard& board, int black_holes) {
+        BoardView view;
+        view.n = board.board_size();
+        view.black_holes = black_holes;
+        view.cells.resize(view.n * view.n);
+        for (auto row = 0; row < view.n; row++) {
+            for (auto col = 0; col < view.n; col++) {
+                view.cells[row * view.n + col] = board.is_opened_cell(row, col) ? (signed char)board.black_holes_nearby(row, col) : -1;
+            }
+        }
+        return view;
+    }
+
+    /*
+        Function: analyze
+        Parameters:
+            view - the visible position
+            cancelled - checked between the steps, the analysis stops once it is set
+            hint - receives the result
+
+        Description: finds the closed cells that are certainly safe or certainly black holes, first by the rules
+        of single numbers, then by comparing the numbers whose closed neighbours include each other.
+        If no safe cell is found, it estimates for each closed cell the probability of a black hole (see estimate)
+        within the limits. If the estimate is out of the limits, the probability is guessed: for a cell next to numbers
+        it is the highest ratio of the holes left to the cells left around them, for any other cell it is the density
+        of the holes left among all unknown cells.
+
+        Returns: false if the analysis was cancelled
+    */
+    bool analyze(const BoardView& view, const std::atomic<bool>& cancelled, Hint& hint, const EstimateLimits& limits) {
+        const int n = view.n;
+        std::vector<Known> known(n * n, Known::Unknown);
+        std::vector<Constraint> constraints;
+        for (auto row = 0; row < n; row++) {
+            for (auto col = 0; col < n; col++) {
+                if (view.cells[row * n + col] <= 0) {
+                    continue;
+                }
+                Constraint c{ {}, view.cells[row * n + col] };
+                for (const auto& d : compass_rose) {
+                    const int r = row + d[1], k = col + d[0];
+                    if (r >= 0 && k >= 0 && r < n && k < n && view.cells[r * n + k] < 0) {
+                        c.cells.push_back(r * n + k);
+                    }
+                }
+                std::sort(c.cells.begin(), c.cells.end());
+                constraints.push_back(std::move(c));
+            }
+        }
+
+        bool found = true;
+        while (found) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            found = apply_single_rules(constraints, known);
+            for (size_t a = 0; a < constraints.size() && !found; a++) {
+                if (cancelled.load(std::memory_order_relaxed)) {
+                    return false;
+                }
+                for (size_t b = 0; b < constraints.size() && !found; b++) {
+                    found = (a != b) && apply_subset_rule(constraints[a], constraints[b], known);
+                }
+            }
+        }
+
+        int holes_left = view.black_holes,
+            unknown = 0;
+        for (auto i = 0; i < n * n; i++) {
+            if (view.cells[i] >= 0) {
+                continue;
+            }
+            switch (known[i]) {
+            case Known::Safe:
+                hint.safe.emplace_back(i / n, i % n);
+                break;
+            case Known::Hole:
+                hint.holes.emplace_back(i / n, i % n);
+                holes_left--;
+                break;
+            default:
+                unknown++;
+                break;
+            }
+        }
+        if (!hint.safe.empty() || 0 == unknown) {
+            return true;
+        }
+
+        Estimate estimated;
+        if (estimate(view, hint.holes, cancelled, limits, estimated)) {
+            for (auto i = 0; i < n * n; i++) {
+                const double p = estimated.probability[i];
+                if (p >= 0 && (hint.guess_row < 0 || p < hint.guess_probability)) {
+                    hint.guess_row = i / n;
+                    hint.guess_col = i % n;
+                    hint.guess_probability = p;
+                    hint.guess_error = estimated.error[i];
+                }
+            }
+            return !cancelled.load(std::memory_order_relaxed);
+        }
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        const double density = std::max(0, holes_left) / (double)unknown;
+        std::vector<double> probability(n * n, -1.0); // -1 for the cells without numbers nearby
+        for (const auto& c : constraints) {
+            for (auto i : c.cells) {
+                probability[i] = std::max(probability[i], c.holes / (double)c.cells.size());
+            }
+        }
+        for (auto i = 0; i < n * n; i++) {
+            if (view.cells[i] >= 0 || Known::Unknown != known[i]) {
+                continue;
+            }
+            const double p = probability[i] < 0 ? density : probability[i];
+            if (hint.guess_row < 0 || p < hint.guess_probability) {
+                hint.guess_row = i / n;
+                hint.guess_col = i % n;
+                hint.guess_probability = p;
+            }
+        }
+        return !cancelled.load(std::memory_order_relaxed);
+    }
+
+    uint64_t position_key(const GameBoard& board, int black_holes) {
+        return board.visible_hash() ^ zobrist_mix((uint64_t)black_holes << 32);
+    }
+
+    uint64_t canonical_key(BoardView& view, BoardSymmetry::Transform& t) {
+        std::vector<signed char> canonical;
+        t = BoardSymmetry::canonicalize(view.n, view.cells, canonical);
+        view.cells.swap(canonical);
+        // Eight cells per word, then one mix per word
+        uint64_t key = zobrist_board(view.n) ^ zobrist_mix((uint64_t)view.black_holes << 32);
+        for (size_t i = 0; i < view.cells.size(); i += 8) {
+            uint64_t word = 0;
+            for (size_t k = i; k < i + 8 && k < view.cells.size(); k++) {
+                word |= (uint64_t)(unsigned char)view.cells[k] << ((k - i) * 8);
+            }
+            key = zobrist_mix(key ^ word);
+        }
+        return key;
+    }
+
+    Hint transform(const Hint& hint, int n, BoardSymmetry::Transform t) {
+        Hint result;
+        auto move = [&](const std::vector<std::pair<int, int>>& from, std::vector<std::pair<int, int>>& to) {
+            for (const auto& cell : from) {
+                to.push_back(BoardSymmetry::apply(t, n, cell.first, cell.second));
+            }
+            std::sort(to.begin(), to.end()); // In the board order, as analyze lists them
+        };
+        move(hint.safe, result.safe);
+        move(hint.holes, result.holes);
+        if (hint.guess_row >= 0) {
+            std::tie(result.guess_row, result.guess_col) = BoardSymmetry::apply(t, n, hint.guess_row, hint.guess_col);
+            result.guess_probability = hint.guess_probability;
+            result.guess_error = hint.guess_error;
+        }
+        return result;
+    }
+
+    TranspositionTable<Hint>& cache() {
+        static TranspositionTable<Hint> hints;
+        return hints;
+    }
+
+    struct HintWorker::Task {
+        int                   n = 0;
+        int                   black_holes = 0;
+        uint64_t              hash_key = 0; // the key of a board larger than MAX_BOARD_SIZE (see position_key)
+        std::vector<uint64_t> holes;        // the masks of the board, see GameBoard::save_masks
+        std::vector<uint64_t> opened;
+        std::atomic<bool>     cancelled{ false };
+        std::atomic<bool>     done{ false };
+        Hint                  hint;
+    };
+
+    HintWorker::HintWorker() {
+        cache(); // The cache is made before the worker, so it is destroyed after it
+    }
+
+    HintWorker::~HintWorker() {
+        cancel();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    void HintWorker::start(const GameBoard& board, int black_holes) {
+        cancel();
+        auto position = std::make_shared<Task>();
+        position->n = board.board_size();
+        position->black_holes = black_holes;
+        position->hash_key = position_key(board, black_holes);
+        const size_t words = (board.board_cells() + 63) / 64;
+        position->holes.resize(words);
+        position->opened.resize(words);
+        board.save_masks(position->holes.data(), position->opened.data());
+        task = position;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            next = position;
+            if (!worker.joinable()) {
+                worker = std::thread(&HintWorker::run, this);
+            }
+        }
+        wake.notify_one();
+    }
+
+    void HintWorker::cancel() {
+        if (task) {
+            task->cancelled.store(true, std::memory_order_relaxed);
+            task.reset();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        next.reset();
+    }
+
+    /*
+        Function: HintWorker::run
+        Parameters: void
+
+        Description: the worker thread. Takes the newest position from the slot and makes its view from the masks
+        (the numbers of the opened cells are counted from the hole mask, hints are for the square topology only).
+        Small boards are analysed and cached in the canonical orientation, so the symmetric positions share the hint;
+        large boards are keyed on their Zobrist hash, taken by start(). Runs until the HintWorker is destroyed.
+
+        Returns: void
+    */
+    void HintWorker::run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || next; });
+            if (stopping) {
+                return;
+            }
+            std::shared_ptr<Task> position = std::move(next);
+            next.reset();
+            lock.unlock();
+
+            const int n = position->n;
+            auto bit = [](const std::vector<uint64_t>& mask, int i) { return (mask[i >> 6] >> (i & 63)) & 1; };
+            BoardView view;
+            view.n = n;
+            view.black_holes = position->black_holes;
+            view.cells.assign(n * n, -1);
+            for (auto i = 0; i < n * n; i++) {
+                if (!bit(position->opened, i)) {
+                    continue;
+                }
+                signed char nearby = 0;
+                for (const auto& d : compass_rose) {
+                    const int r = i / n + d[1], c = i % n + d[0];
+                    nearby += (r >= 0 && c >= 0 && r < n && c < n && bit(position->holes, r * n + c));
+                }
+                view.cells[i] = nearby;
+            }
+            BoardSymmetry::Transform t = BoardSymmetry::Transform::Identity;
+            const uint64_t key = n <= MAX_BOARD_SIZE ? canonical_key(view, t) : position->hash_key;
+            Hint hint;
+            if (cache().lookup(key, hint)) {
+                position->hint = transform(hint, n, BoardSymmetry::inverse(t));
+                position->done.store(true, std::memory_order_release);
+            }
+            else if (analyze(view, position->cancelled, hint)) {
+                cache().store(key, hint);
+                position->hint = transform(hint, n, BoardSymmetry::inverse(t));
+                position->done.store(true, std::memory_order_release);
+            }
+            lock.lock();
+        }
+    }
+
+    const Hint* HintWorker::get() const {
+        return (task && task->done.load(std::memory_order_acquire)) ? &task->hint : nullptr;
+    }
+
+} // namespace GameHint
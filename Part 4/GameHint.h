@@ -0,0 +1,111 @@
+#ifndef GameHint_h
+#define GameHint_h
+
+//
+// Hints: analysis of the visible position (safe cells, black holes, the safest guess),
+// computed on a worker thread while the player is thinking.
+//
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BoardSymmetry.h"
+#include "TranspositionTable.h"
+
+#define HINT_EXACT_NODES (1 << 20) // steps of the exact enumeration of the frontier layouts
+#define HINT_SAMPLE_MS   200       // wall-clock budget of the sampling when the enumeration gives up
+
+class GameBoard;
+
+namespace GameHint {
+
+    // What the player sees: -1 for a closed cell, the number of black holes nearby for an opened one
+    struct BoardView {
+        int                      n = 0;
+        int                      black_holes = 0;
+        std::vector<signed char> cells;
+    };
+
+    struct Hint {
+        std::vector<std::pair<int, int>> safe;  // closed cells that cannot be black holes
+        std::vector<std::pair<int, int>> holes; // closed cells that must be black holes
+        int    guess_row = -1;                  // the closed cell least likely to be a black hole,
+        int    guess_col = -1;                  // if there is no safe cell
+        double guess_probability = 0;           // estimated probability that the guess is a black hole
+        double guess_error = 0;                 // half-width of its 95% confidence interval, 0 if it is exact
+    };
+
+    // Limits of the estimate of the black hole probabilities (see GameEstimate.cpp)
+    struct EstimateLimits {
+        uint64_t exact_nodes = HINT_EXACT_NODES; // the exact enumeration gives up after so many steps
+        int      sample_ms = HINT_SAMPLE_MS;     // wall-clock budget of the sampling, 0 - no sampling
+        int      threads = 0;                    // threads of the sampling, 0 - all hardware threads
+    };
+
+    struct Estimate {
+        std::vector<double> probability; // of a black hole in each cell of the view, -1 for opened and known cells
+        std::vector<double> error;       // half-width of the 95% confidence interval, 0 if exact
+        bool                exact = false;
+        uint64_t            layouts = 0; // layouts counted: solutions enumerated or valid samples drawn
+    };
+
+    BoardView snapshot(const GameBoard& board, int black_holes);
+
+    // Returns false if the analysis was cancelled
+    bool analyze(const BoardView& view, const std::atomic<bool>& cancelled, Hint& hint, const EstimateLimits& limits = EstimateLimits());
+
+    // The probabilities of black holes in the closed cells of the view, except the known 'holes'.
+    // Enumerates the layouts of the holes next to the numbers exactly if it can within the limits, samples them otherwise.
+    // Returns false if cancelled, if there is no layout consistent with the view, or if it is out of the limits.
+    bool estimate(const BoardView& view, const std::vector<std::pair<int, int>>& holes, const std::atomic<bool>& cancelled,
+                  const EstimateLimits& limits, Estimate& result);
+
+    // The key of the position in the cache: the visible board and the number of black holes on it
+    uint64_t position_key(const GameBoard& board, int black_holes);
+
+    // The key of a position on a board up to MAX_BOARD_SIZE, the same for all 8 orientations of the position:
+    // turns the view into the canonical orientation, 't' receives the transform to it
+    uint64_t canonical_key(BoardView& view, BoardSymmetry::Transform& t);
+
+    // The hint for the board turned by the transform
+    Hint transform(const Hint& hint, int n, BoardSymmetry::Transform t);
+
+    // Hints computed before, shared by all workers
+    TranspositionTable<Hint>& cache();
+
+    // Runs the analysis of the current position in the background, unless the cache has the hint for it
+    // (or for a symmetric position) already. One worker thread per HintWorker takes the newest position from a slot:
+    // start() copies the masks of the board (see GameBoard::save_masks) and returns, the view, its key and the lookup
+    // are made on the worker. cancel() flags the running analysis and empties the slot, so a move never waits for it.
+    // The destructor joins the worker.
+    class HintWorker {
+        struct Task;
+        std::shared_ptr<Task>   task; // the position of the game, for get()
+        std::shared_ptr<Task>   next; // the position the worker has not taken yet
+        std::mutex              mutex;
+        std::condition_variable wake;
+        bool                    stopping = false;
+        std::thread             worker; // started by the first start()
+
+        void run();
+    public:
+        HintWorker();
+        HintWorker(const HintWorker&) = delete;
+        HintWorker& operator=(const HintWorker&) = delete;
+        ~HintWorker();
+
+        void start(const GameBoard& board, int black_holes);
+        void cancel();
+        // The hint for the position, nullptr while it is being computed
+        const Hint* get() const;
+    };
+
+} // namespace GameHint
+
+#endif // GameHint_h
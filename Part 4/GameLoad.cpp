@@ -0,0 +1,354 @@
+//
+// GameLoad.cpp
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "GameLoad.h"
+#include "GameController.h"
+#include "GameData.h"
+#include "GameHint.h"
+#include "GameTelemetry.h"
+#include "Helpers.h"
+
+#define LOAD_HISTOGRAM_BITS 5 // 2^bits buckets for each power of two of nanoseconds, about 3% precision
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    enum Operation {
+        NewGameOperation,
+        MoveOperation,
+        QueryOperation,
+        OperationCount
+    };
+
+    const char* operation_names[OperationCount] = { "new_game", "move", "state" };
+
+    // Latencies in log-linear buckets: exact below 2^bits ns, then 2^bits buckets for each power of two
+    class Histogram {
+        static constexpr int sub = 1 << LOAD_HISTOGRAM_BITS;
+        std::vector<uint64_t> counts = std::vector<uint64_t>(64 * sub, 0);
+        uint64_t total = 0,
+                 max = 0;
+
+        static int bucket(uint64_t ns) {
+            if (ns < (uint64_t)sub) {
+                return (int)ns;
+            }
+            const int shift = 63 - __builtin_clzll(ns) - LOAD_HISTOGRAM_BITS;
+            return ((shift + 1) << LOAD_HISTOGRAM_BITS) + (int)((ns >> shift) - sub);
+        }
+
+        // The middle of the bucket
+        static double value(int bucket) {
+            if (bucket < sub) {
+                return bucket;
+            }
+            const int shift = (bucket >> LOAD_HISTOGRAM_BITS) - 1;
+            return (double)((uint64_t)(bucket % sub + sub) << shift) + (double)((uint64_t)1 << shift) / 2;
+        }
+
+    public:
+        void record(uint64_t ns) {
+            counts[bucket(ns)]++;
+            total++;
+            max = std::max(max, ns);
+        }
+
+        void merge(const Histogram& other) {
+            for (size_t b = 0; b < counts.size(); b++) {
+                counts[b] += other.counts[b];
+            }
+            total += other.total;
+            max = std::max(max, other.max);
+        }
+
+        uint64_t count() const {
+            return total;
+        }
+
+        double maximum() const {
+            return (double)max;
+        }
+
+        // The latency that the fraction q of the operations do not exceed
+        double percentile(double q) const {
+            const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * total + 0.5));
+            uint64_t seen = 0;
+            for (size_t b = 0; b < counts.size(); b++) {
+                if ((seen += counts[b]) >= rank) {
+                    return std::min(value((int)b), (double)max);
+                }
+            }
+            return (double)max;
+        }
+    };
+
+    struct Player {
+        std::unique_ptr<GameBoard>       board;
+        std::vector<std::pair<int, int>> safe; // the cells that are not black holes, in the order of the moves
+        size_t                           next_safe = 0;
+        uint64_t                         operations = 0;
+    };
+
+    struct WorkerResult {
+        Histogram latency[OperationCount];
+        Histogram lag;      // from the scheduled time to the start of the operation, with a rate only
+        uint64_t  wins = 0;
+        uint64_t  unfinished = 0; // operations scheduled during the run and not started before the hard stop
+    };
+
+    Operation next_operation(const Player& player) {
+        if (!player.board || player.board->IsGameover()) {
+            return NewGameOperation;
+        }
+        return (player.operations % LOAD_QUERY_EVERY == LOAD_QUERY_EVERY - 1) ? QueryOperation : MoveOperation;
+    }
+
+    // Runs the operation of the player, see next_operation
+    void run_operation(Player& player, Operation kind, const LoadOptions& options, std::mt19937_64& rgen,
+                       GameHint::BoardView& view, WorkerResult& result) {
+        const int n = options.size;
+        player.operations++;
+        switch (kind) {
+        case NewGameOperation: {
+            if (!player.board) {
+                player.board = make_game_board(n);
+            }
+            const std::vector<int> cells = shuffled_cells(n * n, options.black_holes, rgen);
+            player.board->setup(n, std::vector<int>(cells.begin(), cells.begin() + options.black_holes));
+            if (GameTelemetry::enabled()) {
+                GameTelemetry::game_start(*player.board, options.black_holes);
+            }
+            player.safe.clear();
+            for (auto i = options.black_holes; i < n * n; i++) {
+                player.safe.emplace_back(cells[i] / n, cells[i] % n);
+            }
+            player.next_safe = 0;
+            break;
+        }
+        case MoveOperation:
+            while (player.board->is_opened_cell(player.safe[player.next_safe].first, player.safe[player.next_safe].second)) {
+                player.next_safe++; // Opened by the area of an earlier move
+            }
+            if (MoveResult::Win == DoMove(*player.board, player.safe[player.next_safe].first, player.safe[player.next_safe].second)) {
+                result.wins++;
+            }
+            break;
+        default:
+            view = GameHint::snapshot(*player.board, options.black_holes);
+            break;
+        }
+    }
+
+    // Sleeps until the spin margin before the time, then spins: a sleep often wakes up late by tens of microseconds
+    void wait_until(Clock::time_point when, Clock::duration spin) {
+        if (when - Clock::now() > spin) {
+            std::this_thread::sleep_until(when - spin);
+        }
+        while (Clock::now() < when) {
+        }
+    }
+
+    uint64_t nanoseconds(Clock::duration d) {
+        return (uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+    /*
+        Function: run_worker
+        Parameters:
+            options - the load
+            players - the players of this thread
+            total_players - the players of all threads, for the rate of each player
+            threads - the threads, for the rate of each thread in the open loop
+            start, end - the operations are scheduled in [start, end)
+            stop - the hard stop, operations not started before it are counted as unfinished
+            seed - the random numbers of the thread
+            result - receives the latencies
+
+        Description: the closed loop keeps the players in a queue by the time of their next operation,
+        the open loop draws the arrivals of the thread from an exponential distribution (see GameLoad.h).
+        The latency of a scheduled operation is measured from its scheduled time, the lag of its start is recorded apart.
+
+        Returns: void
+    */
+    void run_worker(const LoadOptions& options, std::vector<Player>& players, int total_players, int threads,
+                    Clock::time_point start, Clock::time_point end, Clock::time_point stop, uint64_t seed, WorkerResult& result) {
+        std::mt19937_64 rgen(seed);
+        GameHint::BoardView view;
+        const auto spin = std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(options.spin_us));
+        auto operation = [&](Player& player, Clock::time_point scheduled) {
+            const Operation kind = next_operation(player);
+            const auto begin = Clock::now();
+            run_operation(player, kind, options, rgen, view, result);
+            result.latency[kind].record(nanoseconds(Clock::now() - (options.rate > 0 ? scheduled : begin)));
+            if (options.rate > 0) {
+                result.lag.record(nanoseconds(begin - scheduled));
+            }
+        };
+
+        if (options.open_loop) {
+            std::exponential_distribution<double> gap(options.rate / threads);
+            std::uniform_int_distribution<size_t> who(0, players.size() - 1);
+            for (auto arrival = start; ; ) {
+                arrival += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(rgen)));
+                if (arrival >= end) {
+                    break;
+                }
+                if (Clock::now() >= stop) {
+                    result.unfinished++;
+                    continue;
+                }
+                wait_until(arrival, spin);
+                operation(players[who(rgen)], arrival);
+            }
+            return;
+        }
+
+        const auto interval = options.rate > 0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(total_players / options.rate))
+            : Clock::duration::zero();
+        using Due = std::pair<Clock::time_point, size_t>;
+        std::priority_queue<Due, std::vector<Due>, std::greater<Due>> queue;
+        for (size_t p = 0; p < players.size(); p++) { // Spread over the first interval
+            queue.emplace(start + interval * (int64_t)(p * threads) / total_players, p);
+        }
+        while (!queue.empty()) {
+            const Due due = queue.top();
+            queue.pop();
+            if (due.first >= end) {
+                continue;
+            }
+            if (Clock::now() >= stop) {
+                result.unfinished += 1 + (uint64_t)((end - due.first) / std::max(interval, Clock::duration(1)));
+                continue;
+            }
+            wait_until(due.first, spin);
+            operation(players[due.second], due.first);
+            queue.emplace(options.rate > 0 ? due.first + interval : Clock::now(), due.second);
+        }
+    }
+
+} // namespace
+
+/*
+    Function: RunLoad
+    Parameters:
+        filename - the file for the results, nullptr for stdout
+        json - write JSON instead of text
+        options - the load
+
+    Description: shares the players out between the hardware threads, runs them for the length of the run,
+    then merges the latencies of the threads and writes the percentiles of each kind of operation.
+    An overloaded run goes on for up to the length of the run again to finish the operations scheduled during it.
+
+    Returns: 0 on success, 1 if the options are not valid or the results cannot be written
+*/
+int RunLoad(const char* filename, bool json, const LoadOptions& options) {
+    if (options.players < 1 || options.seconds <= 0 || options.rate < 0 || (options.open_loop && options.rate <= 0) || options.spin_us < 0 ||
+        options.size < MIN_BOARD_SIZE || options.black_holes < MIN_BLACK_HOLES || options.black_holes > MAX_BLACK_HOLES(options.size)) {
+        std::cerr << "The load is not valid" << (options.open_loop && options.rate <= 0 ? ", the open loop needs a rate" : "") << "\n";
+        return 1;
+    }
+    const int threads = (int)std::min<unsigned>(std::max(1u, std::thread::hardware_concurrency()), (unsigned)options.players);
+    std::vector<std::vector<Player>> players(threads);
+    for (int p = 0; p < options.players; p++) {
+        players[p % threads].emplace_back();
+    }
+    std::vector<WorkerResult> results(threads);
+
+    const auto start = Clock::now() + std::chrono::milliseconds(10); // Let all threads start first
+    const auto length = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    const auto end = start + length,
+               stop = end + length;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(run_worker, std::cref(options), std::ref(players[t]), options.players, threads,
+                             start, end, stop, zobrist_mix((uint64_t)t), std::ref(results[t]));
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WorkerResult all;
+    for (const auto& r : results) {
+        for (int k = 0; k < OperationCount; k++) {
+            all.latency[k].merge(r.latency[k]);
+        }
+        all.lag.merge(r.lag);
+        all.wins += r.wins;
+        all.unfinished += r.unfinished;
+    }
+    uint64_t operations = 0;
+    for (const auto& h : all.latency) {
+        operations += h.count();
+    }
+
+    std::ofstream file;
+    if (filename) {
+        file.open(filename, std::ios::trunc);
+    }
+    std::ostream& os = filename ? file : std::cout;
+    const char* mode = options.open_loop ? "open" : "closed";
+    char line[512];
+    if (json) {
+        std::snprintf(line, sizeof(line),
+            "{\"mode\":\"%s\",\"players\":%d,\"threads\":%d,\"rate\":%.0f,\"seconds\":%.2f,\"size\":%d,\"black_holes\":%d,"
+            "\"elapsed\":%.3f,\"operations_total\":%llu,\"throughput\":%.0f,\"wins\":%llu,\"unfinished\":%llu,\"operations\":[",
+            mode, options.players, threads, options.rate, options.seconds, options.size, options.black_holes, elapsed,
+            (unsigned long long)operations, operations / elapsed, (unsigned long long)all.wins, (unsigned long long)all.unfinished);
+    }
+    else {
+        std::snprintf(line, sizeof(line),
+            "Load: %s loop, %d players on %d threads, rate %.0f per second (0 - as fast as possible), %.2f s, "
+            "%dx%d boards with %d black holes\n"
+            "Operations: %llu in %.3f s, %.0f per second, games won: %llu, unfinished: %llu\n"
+            "%-10s %10s %10s %10s %10s %10s %10s\n",
+            mode, options.players, threads, options.rate, options.seconds, options.size, options.size, options.black_holes,
+            (unsigned long long)operations, elapsed, operations / elapsed, (unsigned long long)all.wins,
+            (unsigned long long)all.unfinished, "operation", "count", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+    }
+    os << line;
+    auto write_row = [&](const char* name, const Histogram& h, const char* separator) {
+        std::snprintf(line, sizeof(line), json
+            ? "%s{\"name\":\"%s\",\"count\":%llu,\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,\"p999_us\":%.2f,\"max_us\":%.2f}"
+            : "%s%-10s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+            separator, name, (unsigned long long)h.count(), h.percentile(0.5) / 1e3,
+            h.percentile(0.9) / 1e3, h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3, h.maximum() / 1e3);
+        os << line;
+    };
+    for (int k = 0; k < OperationCount; k++) {
+        write_row(operation_names[k], all.latency[k], (json && k) ? "," : "");
+    }
+    // The lag of the generator is part of every latency above, it is not an operation
+    if (json) {
+        os << "]";
+        if (options.rate > 0) {
+            os << ",\"spin_us\":" << options.spin_us << ",\"lag\":";
+            write_row("lag", all.lag, "");
+        }
+        os << "}\n";
+    }
+    else if (options.rate > 0) {
+        os << "Generator lag (the start of the operations after their scheduled time, spin margin " << options.spin_us << " us):\n";
+        write_row("lag", all.lag, "");
+    }
+    os.flush();
+    if (!os) {
+        std::cerr << "Cannot write the results to " << (filename ? filename : "stdout") << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef GameLoad_h
+#define GameLoad_h
+
+//
+// Load generator: many simulated players play their own games against the engine in this process, on all hardware
+// threads, to size the hardware for concurrent games. Each player starts a new game, opens its cells and queries the
+// state of its game (the visible board, as the B command of the scripted mode) once in LOAD_QUERY_EVERY operations.
+// The players know where the black holes are, so every game is played to the win at the same pace.
+//
+// Closed loop: each player has one operation in flight. With a rate, the operations of a player are scheduled
+// at fixed intervals and the latency is measured from the scheduled time, not from the time the operation could
+// start, so a stall is accounted to every operation it delayed (the correction of coordinated omission).
+// Without a rate, the players go as fast as they can and the latency is the service time.
+// Open loop: the operations arrive at the rate as a Poisson process, to random players, whether or not the
+// operations before them are done; the latency is measured from the arrival.
+//
+// The percentiles of the latency of each kind of operation are written as text or JSON, to compare builds.
+// With a rate, the lag of the generator itself (how late an operation started after its scheduled time) is written
+// as well: a latency close to the lag is the harness, not the engine. A thread sleeps until the spin margin before
+// the operation is due and spins from there, a larger margin trades CPU time for less lag.
+//
+
+#define LOAD_PLAYERS     64 // simulated players by default
+#define LOAD_SECONDS     5  // length of the run by default
+#define LOAD_QUERY_EVERY 4  // one operation of a player in this many is a state query
+#define LOAD_BOARD_SIZE  16 // the games of the players by default
+#define LOAD_BLACK_HOLES 40
+#define LOAD_SPIN_US     250 // spin margin by default, above the usual lateness of a sleep
+
+struct LoadOptions {
+    int    players = LOAD_PLAYERS;
+    double rate = 0;         // operations per second of all players, 0 - as fast as possible (closed loop only)
+    double seconds = LOAD_SECONDS;
+    bool   open_loop = false;
+    int    size = LOAD_BOARD_SIZE;
+    int    black_holes = LOAD_BLACK_HOLES;
+    int    spin_us = LOAD_SPIN_US; // the last microseconds before an operation are spun, not slept
+};
+
+// Returns 0 on success, 1 if the options are not valid or the results cannot be written
+int RunLoad(const char* filename, bool json, const LoadOptions& options);
+
+#endif // GameLoad_h
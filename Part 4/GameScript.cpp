@@ -0,0 +1,376 @@
+//
+// GameScript.cpp
+//
+// Non-interactive (scripted) mode: reads a command stream from stdin or a file,
+// prints no prompts and answers every command with one machine-readable line.
+//
+// Commands (case insensitive, separated by any whitespace):
+//
+//   S <size> <holes>   apply game settings       -> "settings <size> <holes>" | "error settings"
+//   N                  start a new random game   -> "new <size> <holes>"
+//   F <filename>       start a game from a file  -> "new <size> <holes>" | "error file"
+//   <row> <col>        open a cell (1-based)     -> "move <row> <col> <result> <hidden cells>"
+//                      where result is one of play, win, lost, invalid, opened, nogame
+//   M <count> <row> <col> ...                    -> "moves <applied> <skipped> <opened> <state> <hidden cells>"
+//                      open the cells in one batch, where state is one of play, win, lost, nogame
+//                      (see GameBoard::apply_moves)
+//   B                  show the visible board    -> "board <size> <cells>", cells are row by row,
+//                      '#' - closed cell, 'H' - black hole, '0'..'8' - opened cell
+//   W <filename>       save the game snapshot    -> "saved <bytes>" | "error save" (see GameSnapshot)
+//   R <filename>       restore a game snapshot   -> "restored <size> <holes> <state> <hidden cells>" | "error restore"
+//   Q                  quit
+//
+// Anything else is answered with "error <token>". A command with an argument that is not valid is answered with
+// its error and the script goes on; a script that ends in the middle of a command exits with 1.
+//
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "GameScript.h"
+#include "BoardPool.h"
+#include "GameController.h"
+#include "GameData.h"
+#include "GameSnapshot.h"
+#include "GameTelemetry.h"
+
+#define SCRIPT_INPUT_BUFFER  (1 << 20)
+#define SCRIPT_OUTPUT_FLUSH  (1 << 16)
+
+namespace {
+
+#ifdef _WIN32
+    int open_input(const char* filename) { return _open(filename, _O_RDONLY | _O_BINARY); }
+    int read_input(int fd, char* buf, unsigned int size) { return _read(fd, buf, size); }
+    void close_input(int fd) { _close(fd); }
+#else
+    int open_input(const char* filename) { return open(filename, O_RDONLY); }
+    int read_input(int fd, char* buf, unsigned int size) { return (int)read(fd, buf, size); }
+    void close_input(int fd) { close(fd); }
+#endif
+
+    // Buffered output, written with a single fwrite when it grows large or before we block on input
+    class ScriptWriter {
+        std::string out;
+    public:
+        ScriptWriter() { out.reserve(SCRIPT_OUTPUT_FLUSH * 2); }
+        ~ScriptWriter() { flush(); }
+
+        ScriptWriter& put(const char* s) { out.append(s); return *this; }
+        ScriptWriter& put(const char* s, size_t len) { out.append(s, len); return *this; }
+        ScriptWriter& put(char c) { out.push_back(c); return *this; }
+        ScriptWriter& put(int value) {
+            char buf[16];
+            auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr - buf);
+            return *this;
+        }
+        void end_line() {
+            out.push_back('\n');
+            if (out.size() >= SCRIPT_OUTPUT_FLUSH) {
+                flush();
+            }
+        }
+        void flush() {
+            if (!out.empty()) {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                std::fflush(stdout);
+                out.clear();
+            }
+        }
+    };
+
+    // Splits the input into whitespace separated tokens over one large read buffer.
+    // A read returns whatever is available, so a harness may also talk to us through a pipe
+    // one command at a time: all pending answers are flushed before we wait for more input.
+    class ScriptReader {
+        int         fd;
+        ScriptWriter& writer;
+        std::string buf;
+        size_t      pos = 0,
+                    end = 0;
+        bool        eof = false;
+
+        static bool is_space(char c) { return (' ' == c || '\t' == c || '\n' == c || '\r' == c || '\f' == c || '\v' == c); }
+
+        // Moves [from, end) to the front and appends more input after it, returns false at the end of input
+        bool refill(size_t from) {
+            std::memmove(&buf[0], &buf[from], end - from);
+            end -= from;
+            pos -= from;
+            if (eof) {
+                return false;
+            }
+            if (end == buf.size()) { // a single token does not fit into the buffer
+                buf.resize(buf.size() * 2);
+            }
+            writer.flush();
+            int got = read_input(fd, &buf[end], (unsigned int)(buf.size() - end));
+            if (got <= 0) {
+                eof = true;
+                return false;
+            }
+            end += got;
+            return true;
+        }
+
+    public:
+        ScriptReader(int fd, ScriptWriter& writer) : fd(fd), writer(writer), buf(SCRIPT_INPUT_BUFFER, '\0') {}
+
+        // Returns false at the end of input, otherwise [token, token + len) is valid until the next call
+        bool next(const char*& token, size_t& len) {
+            while (true) {
+                while (pos < end && is_space(buf[pos])) {
+                    pos++;
+                }
+                if (pos < end) {
+                    break;
+                }
+                if (!refill(pos)) {
+                    return false;
+                }
+            }
+            size_t start = pos;
+            while (true) {
+                while (pos < end && !is_space(buf[pos])) {
+                    pos++;
+                }
+                if (pos < end) {
+                    break;
+                }
+                const bool more = refill(start);
+                start = 0; // The token is at the front of the buffer now
+                if (!more) {
+                    break;
+                }
+            }
+            token = &buf[start];
+            len = pos - start;
+            return true;
+        }
+    };
+
+    // A whole token of decimal digits with an optional '-', out of the range of int is not a number
+    bool parse_int(const char* token, size_t len, int& value) {
+        const auto result = std::from_chars(token, token + len, value);
+        return std::errc() == result.ec && token + len == result.ptr;
+    }
+
+    bool is_command(const char* token, size_t len, char cmd) {
+        return (1 == len && (token[0] | 0x20) == cmd);
+    }
+
+    const char* game_state_name(GameState state) {
+        switch (state) {
+        case GameState::Win:  return "win";
+        case GameState::Lost: return "lost";
+        default:              return "play";
+        }
+    }
+
+    void write_board(ScriptWriter& writer, const GameBoard& board) {
+        writer.put("board ").put(board.board_size()).put(' ');
+        for (auto row = 0; row < board.board_rows(); ++row) {
+            for (auto col = 0; col < board.board_cols(); ++col) {
+                char cell = '#';
+                if (board.is_opened_cell(row, col)) {
+                    cell = board.is_black_hole_cell(row, col) ? 'H' : (char)('0' + board.black_holes_nearby(row, col));
+                }
+                writer.put(cell);
+            }
+        }
+        writer.end_line();
+    }
+
+} // namespace
+
+/*
+    Function: RunScript
+    Parameters:
+        filename - script file, or nullptr to read commands from stdin
+
+    Description: the main thread of the non-interactive mode (see the command list above)
+
+    Returns integer:
+        0 - success
+        1 - the script cannot be opened, or it ends in the middle of a command
+
+*/
+int RunScript(const char* filename) {
+    int fd = filename ? open_input(filename) : 0;
+    if (fd < 0) {
+        std::fprintf(stderr, "Cannot open script %s\n", filename);
+        return 1;
+    }
+
+    ScriptWriter writer;
+    ScriptReader reader(fd, writer);
+    std::unique_ptr<GameBoard> game_board;
+
+    const char* token;
+    size_t len;
+    bool incomplete = false; // the script ended in the middle of a command
+    auto next_arg = [&](const char*& arg, size_t& arg_len) {
+        incomplete = !reader.next(arg, arg_len);
+        return !incomplete;
+    };
+    while (reader.next(token, len)) {
+        int row, col;
+        if (parse_int(token, len, row)) {
+            const char* arg;
+            size_t arg_len;
+            if (!next_arg(arg, arg_len) || !parse_int(arg, arg_len, col)) {
+                writer.put("error move").end_line();
+                if (incomplete) {
+                    break;
+                }
+                continue;
+            }
+            writer.put("move ").put(row).put(' ').put(col).put(' ');
+            if (!game_board || game_board->IsGameover()) {
+                writer.put("nogame 0").end_line();
+                continue;
+            }
+            // Rows and columns are 1-based for a player
+            writer.put(move_result_name(DoMove(*game_board, row - 1, col - 1))).put(' ').put(game_board->hidden_cells());
+            writer.end_line();
+        }
+        else if (is_command(token, len, 'm')) {
+            const char* arg;
+            size_t arg_len;
+            int count = 0;
+            bool valid = next_arg(arg, arg_len) && parse_int(arg, arg_len, count) && count >= 0;
+            std::vector<std::pair<int, int>> cells;
+            for (int i = 0; valid && i < count; i++) {
+                valid = next_arg(arg, arg_len) && parse_int(arg, arg_len, row) &&
+                        next_arg(arg, arg_len) && parse_int(arg, arg_len, col);
+                cells.emplace_back(row - 1, col - 1); // Rows and columns are 1-based for a player
+            }
+            if (!valid) {
+                writer.put("error moves").end_line();
+                if (incomplete) {
+                    break;
+                }
+                continue;
+            }
+            if (!game_board || game_board->IsGameover()) {
+                writer.put("moves 0 0 0 nogame 0").end_line();
+                continue;
+            }
+            const MovesResult result = game_board->apply_moves(cells);
+            writer.put("moves ").put(result.applied).put(' ').put(result.skipped).put(' ').put(result.opened).put(' ')
+                .put(game_state_name(result.state)).put(' ').put(game_board->hidden_cells());
+            writer.end_line();
+        }
+        else if (is_command(token, len, 'n')) {
+            game_board = NewGame();
+            writer.put("new ").put(GameSettings::getSettings().get_board_size()).put(' ').put(GameSettings::getSettings().get_black_holes());
+            writer.end_line();
+        }
+        else if (is_command(token, len, 's')) {
+            int board_size(0), black_holes(0);
+            const char* arg;
+            size_t arg_len;
+            bool valid = next_arg(arg, arg_len) && parse_int(arg, arg_len, board_size) &&
+                         next_arg(arg, arg_len) && parse_int(arg, arg_len, black_holes) &&
+                         board_size >= MIN_BOARD_SIZE && board_size <= MAX_BOARD_SIZE &&
+                         black_holes >= MIN_BLACK_HOLES && black_holes <= MAX_BLACK_HOLES(board_size);
+            if (valid) {
+                GameSettings::getSettings().set_board_size(board_size);
+                GameSettings::getSettings().set_black_holes(black_holes);
+                BoardPool::configure();
+                writer.put("settings ").put(board_size).put(' ').put(black_holes).end_line();
+            }
+            else {
+                writer.put("error settings").end_line();
+                if (incomplete) {
+                    break;
+                }
+            }
+        }
+        else if (is_command(token, len, 'f')) {
+            const char* arg;
+            size_t arg_len;
+            if (!next_arg(arg, arg_len)) {
+                writer.put("error file").end_line();
+                break;
+            }
+            std::string board_file(arg, arg_len);
+            game_board = NewGame(board_file.c_str());
+            if (game_board) {
+                writer.put("new ").put(GameSettings::getSettings().get_board_size()).put(' ').put(GameSettings::getSettings().get_black_holes());
+                writer.end_line();
+            }
+            else {
+                writer.put("error file").end_line();
+            }
+        }
+        else if (is_command(token, len, 'b')) {
+            if (game_board) {
+                write_board(writer, *game_board);
+            }
+            else {
+                writer.put("error nogame").end_line();
+            }
+        }
+        else if (is_command(token, len, 'w')) {
+            const char* arg;
+            size_t arg_len;
+            if (!next_arg(arg, arg_len)) {
+                writer.put("error save").end_line();
+                break;
+            }
+            if (game_board && GameSnapshot::save_file(std::string(arg, arg_len), *game_board)) {
+                writer.put("saved ").put((int)(GameSnapshot::words_for(game_board->board_size()) * sizeof(uint64_t))).end_line();
+            }
+            else {
+                writer.put("error save").end_line();
+            }
+        }
+        else if (is_command(token, len, 'r')) {
+            const char* arg;
+            size_t arg_len;
+            if (!next_arg(arg, arg_len)) {
+                writer.put("error restore").end_line();
+                break;
+            }
+            int black_holes = 0;
+            auto restored = GameSnapshot::load_file(std::string(arg, arg_len), black_holes);
+            if (restored) {
+                game_board = std::move(restored);
+                GameSettings::getSettings().set_board_size(game_board->board_size());
+                GameSettings::getSettings().set_black_holes(black_holes);
+                if (GameTelemetry::enabled()) {
+                    GameTelemetry::game_start(*game_board, black_holes);
+                }
+                const GameState state = game_board->IsGameover() ? (game_board->IsWin() ? GameState::Win : GameState::Lost) : GameState::Play;
+                writer.put("restored ").put(game_board->board_size()).put(' ').put(black_holes).put(' ')
+                    .put(game_state_name(state)).put(' ').put(game_board->hidden_cells());
+                writer.end_line();
+            }
+            else {
+                writer.put("error restore").end_line();
+            }
+        }
+        else if (is_command(token, len, 'q')) {
+            break;
+        }
+        else {
+            writer.put("error ").put(token, len).end_line();
+        }
+    }
+
+    if (filename) {
+        close_input(fd);
+    }
+    return incomplete ? 1 : 0;
+}
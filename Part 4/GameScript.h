@@ -0,0 +1,6 @@
+#ifndef GameScript_h
+#define GameScript_h
+
+int RunScript(const char* filename);
+
+#endif // GameScript_h
@@ -0,0 +1,163 @@
+//
+// GameSnapshot.cpp
+//
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "GameSnapshot.h"
+
+namespace {
+
+    uint64_t checksum(const uint64_t* words, size_t count) {
+        uint64_t sum = SNAPSHOT_MAGIC;
+        for (size_t i = 0; i < count; i++) {
+            sum = zobrist_mix(sum ^ words[i]);
+        }
+        return sum;
+    }
+
+    // In size_t: the size read by load is not checked yet, and its square may overflow an int
+    size_t mask_words(int size) {
+        return ((size_t)size * size + 63) / 64;
+    }
+
+    int count_bits(const uint64_t* mask, size_t words) {
+        int bits = 0;
+        for (size_t i = 0; i < words; i++) {
+            bits += __builtin_popcountll(mask[i]);
+        }
+        return bits;
+    }
+
+} // namespace
+
+size_t GameSnapshot::words_for(int size) {
+    return 3 + 2 * mask_words(size);
+}
+
+/*
+    Function: save
+    Parameters:
+        board - the game
+        snapshot - receives the words of the snapshot
+
+    Description: packs the header, the masks of the board (see GameBoard::save_masks) and the checksum.
+    The number of black holes in the header is the one of the hole mask.
+
+    Returns: void
+*/
+void GameSnapshot::save(const GameBoard& board, std::vector<uint64_t>& snapshot) {
+    GAME_STATS_TIMER(Snapshot);
+    const int n = board.board_size();
+    const size_t words = mask_words(n);
+    const GameState state = board.IsGameover() ? (board.IsWin() ? GameState::Win : GameState::Lost) : GameState::Play;
+    snapshot.resize(words_for(n));
+    snapshot[0] = ((uint64_t)SNAPSHOT_MAGIC << 32) | ((uint64_t)SNAPSHOT_VERSION << 24) | ((uint64_t)state << 16) | (uint16_t)n;
+    board.save_masks(&snapshot[2], &snapshot[2 + words]);
+    const int black_holes = count_bits(&snapshot[2], words);
+    snapshot[1] = ((uint64_t)(uint32_t)black_holes << 32) | ((uint64_t)board.topology() << 24) | (uint32_t)words;
+    snapshot.back() = checksum(snapshot.data(), snapshot.size() - 1);
+}
+
+/*
+    Function: load
+    Parameters:
+        snapshot - the words of the snapshot
+        words - their number
+        black_holes - receives the number of black holes of the game
+
+    Description: checks the snapshot before the board is made: the magic, the version, the size of the board
+    and of the snapshot, the checksum, and that the masks are a position of the game: no cells beyond the board,
+    as many black holes as the header says, a black hole opened if and only if the game is lost, and no closed
+    safe cell if the game is won and at least one if it is played. The board is restored from the masks by GameBoard::restore_masks,
+    which recomputes the numbers of the cells, the counts of the tiles and the region index from the hole mask
+    (they are not in the snapshot, to keep it small), so a restore costs a few times a save.
+
+    Returns: the board of the game, or nullptr if the snapshot is not valid
+*/
+std::unique_ptr<GameBoard> GameSnapshot::load(const uint64_t* snapshot, size_t words, int& black_holes) {
+    GAME_STATS_TIMER(Snapshot);
+    if (words < 3 || (snapshot[0] >> 32) != SNAPSHOT_MAGIC || ((snapshot[0] >> 24) & 0xFF) != SNAPSHOT_VERSION) {
+        return nullptr;
+    }
+    const int n = (int)(snapshot[0] & 0xFFFF);
+    const size_t mask = mask_words(n);
+    const GameState state = (GameState)((snapshot[0] >> 16) & 0xFF);
+    const BoardTopology topology = (BoardTopology)((snapshot[1] >> 24) & 0xFF);
+    if (n < MIN_BOARD_SIZE || words != words_for(n) || (snapshot[1] & 0xFFFFFF) != mask ||
+        topology > BoardTopology::Torus ||
+        snapshot[words - 1] != checksum(snapshot, words - 1) ||
+        (GameState::Play != state && GameState::Win != state && GameState::Lost != state)) {
+        return nullptr;
+    }
+    const uint64_t* holes = snapshot + 2;
+    const uint64_t* opened = holes + mask;
+    const int tail = (int)((size_t)n * n % 64);
+    if (tail && ((holes[mask - 1] | opened[mask - 1]) >> tail)) {
+        return nullptr; // Cells beyond the board
+    }
+    bool opened_hole = false, closed_safe = false;
+    for (size_t i = 0; i < mask; i++) {
+        const uint64_t cells = i + 1 < mask || !tail ? ~0ull : (1ull << tail) - 1;
+        opened_hole = opened_hole || (holes[i] & opened[i]);
+        closed_safe = closed_safe || (cells & ~holes[i] & ~opened[i]);
+    }
+    if (opened_hole != (GameState::Lost == state) || (GameState::Lost != state && closed_safe == (GameState::Win == state))) {
+        return nullptr; // The state is not the one of the masks
+    }
+    const int holes_count = count_bits(holes, mask);
+    if (holes_count < MIN_BLACK_HOLES || holes_count > MAX_BLACK_HOLES(n) || (snapshot[1] >> 32) != (uint64_t)holes_count) {
+        return nullptr;
+    }
+
+    black_holes = holes_count;
+    auto board = make_game_board(n, topology);
+    board->restore_masks(n, holes, opened, state);
+    return board;
+}
+
+bool GameSnapshot::save_file(const std::string& filename, const GameBoard& board) {
+    std::vector<uint64_t> snapshot;
+    save(board, snapshot);
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size() * sizeof(uint64_t));
+        if (!out) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return 0 == std::rename(temporary.c_str(), filename.c_str());
+}
+
+std::unique_ptr<GameBoard> GameSnapshot::load_file(const std::string& filename, int& black_holes) {
+    std::ifstream in(filename, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.empty() || bytes.size() % sizeof(uint64_t)) {
+        return nullptr;
+    }
+    std::vector<uint64_t> snapshot(bytes.size() / sizeof(uint64_t));
+    std::copy(bytes.begin(), bytes.end(), reinterpret_cast<char*>(snapshot.data()));
+    return load(snapshot.data(), snapshot.size(), black_holes);
+}
+
+std::string GameSnapshot::spill_file(const std::string& directory, uint64_t session) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)session);
+    return directory + "/" + name + SNAPSHOT_EXTENSION;
+}
+
+bool GameSnapshot::evict(const std::string& directory, uint64_t session, const GameBoard& board) {
+    return save_file(spill_file(directory, session), board);
+}
+
+std::unique_ptr<GameBoard> GameSnapshot::resume(const std::string& directory, uint64_t session, int& black_holes) {
+    const std::string filename = spill_file(directory, session);
+    auto board = load_file(filename, black_holes);
+    if (board) {
+        std::remove(filename.c_str());
+    }
+    return board;
+}
@@ -0,0 +1,58 @@
+#ifndef GameSnapshot_h
+#define GameSnapshot_h
+
+//
+// Compact snapshots of games in progress, to keep a game over a restart or to evict an idle session to disk.
+// A snapshot is a few 64-bit words in the native byte order:
+//
+//   word 0        magic (32 bits) | version (8) | state (8) | board size (16)
+//   word 1        black holes of the board (32) | topology (8) | words of each mask (24)
+//   masks         the black holes, then the opened cells, one bit a cell (see GameBoard::save_masks)
+//   last word     checksum of all the words before it
+//
+// A 16x16 game takes 88 bytes. The board is restored from the masks as it was, no move is replayed; the numbers of
+// the cells, the counts of the tiles and the region index are not stored, they are recomputed from the hole mask,
+// so a restore costs a few times a save.
+//
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameData.h"
+
+#define SNAPSHOT_MAGIC     0x50585353u // "PXSS"
+#define SNAPSHOT_VERSION   1
+#define SNAPSHOT_EXTENSION ".snapshot"
+
+namespace GameSnapshot {
+
+    // The words of the snapshot of a board of the size
+    size_t words_for(int size);
+
+    // Writes the snapshot of the game into 'snapshot'
+    void save(const GameBoard& board, std::vector<uint64_t>& snapshot);
+
+    // Restores the game, black_holes receives the number of its black holes.
+    // Returns nullptr if the snapshot is truncated, damaged, of another version or not a position of the game.
+    std::unique_ptr<GameBoard> load(const uint64_t* snapshot, size_t words, int& black_holes);
+
+    // The same through a file: the file is written next to its final name and renamed, so it is never seen half written.
+    // save_file returns false if the file cannot be written, load_file returns nullptr if it cannot be read or restored.
+    bool save_file(const std::string& filename, const GameBoard& board);
+    std::unique_ptr<GameBoard> load_file(const std::string& filename, int& black_holes);
+
+    // Eviction of idle sessions: the file of the session in the spill directory
+    std::string spill_file(const std::string& directory, uint64_t session);
+
+    // Saves the game of the session into the spill directory, the caller may drop the board then
+    bool evict(const std::string& directory, uint64_t session, const GameBoard& board);
+
+    // Restores the game of the session from the spill directory and removes its file.
+    // Returns nullptr if the session has no valid file.
+    std::unique_ptr<GameBoard> resume(const std::string& directory, uint64_t session, int& black_holes);
+
+} // namespace GameSnapshot
+
+#endif // GameSnapshot_h
@@ -0,0 +1,182 @@
+//
+// GameStats.cpp
+//
+#include "GameStats.h"
+
+namespace {
+
+    void report_caches(std::ostream& os, bool json, const std::vector<GameStats::CacheCounters>& caches) {
+        if (json) {
+            os << ",\"caches\":[";
+            for (size_t c = 0; c < caches.size(); c++) {
+                os << (c ? "," : "") << "{\"cache\":\"" << caches[c].name << "\",\"capacity\":" << caches[c].capacity
+                   << ",\"hits\":" << caches[c].hits << ",\"misses\":" << caches[c].misses
+                   << ",\"stores\":" << caches[c].stores << ",\"replaced\":" << caches[c].replaced << "}";
+            }
+            os << "]";
+            return;
+        }
+        for (const auto& cache : caches) {
+            os << cache.name << " cache: " << cache.hits << " hits, " << cache.misses << " misses, "
+               << cache.stores << " stores (" << cache.replaced << " replaced), " << cache.capacity << " slots\n";
+        }
+    }
+
+} // namespace
+
+#ifdef GAME_STATS
+
+#include <atomic>
+#include <iomanip>
+
+#define HISTOGRAM_BUCKETS 64 // bucket k counts latencies in [2^k, 2^(k+1)) ns
+
+namespace GameStats {
+
+    namespace {
+
+        struct PhaseStats {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> total_ns{0};
+            std::atomic<uint64_t> max_ns{0};
+            std::atomic<uint64_t> histogram[HISTOGRAM_BUCKETS] = {};
+        };
+
+        PhaseStats phases[(int)Phase::Count];
+
+        std::atomic<uint64_t> opened_cells{0};
+        std::atomic<uint64_t> max_opened_cells{0};
+        std::atomic<uint64_t> max_open_depth{0};
+        std::atomic<uint64_t> adjacent_cells{0};
+
+        const char* phase_names[(int)Phase::Count] = {
+            "setup",
+            "compute_adjacent_black_holes",
+            "build_region_index",
+            "do_open",
+            "hidden_cells",
+            "randoms",
+            "black_holes_from_file",
+            "ShowGameBoard",
+            "snapshot"
+        };
+
+        int bucket(uint64_t ns) {
+            int k = 0;
+            while (ns > 1 && k < HISTOGRAM_BUCKETS - 1) {
+                ns >>= 1;
+                k++;
+            }
+            return k;
+        }
+
+        void update_max(std::atomic<uint64_t>& max, uint64_t value) {
+            uint64_t current = max.load(std::memory_order_relaxed);
+            while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            }
+        }
+
+    } // namespace
+
+    thread_local uint64_t OpenScope::depth = 0;
+    thread_local uint64_t OpenScope::max_depth = 0;
+    thread_local uint64_t OpenScope::cells = 0;
+
+    void record(Phase phase, uint64_t ns) {
+        PhaseStats& ps = phases[(int)phase];
+        ps.calls.fetch_add(1, std::memory_order_relaxed);
+        ps.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        update_max(ps.max_ns, ns);
+        ps.histogram[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_open(uint64_t cells, uint64_t depth) {
+        opened_cells.fetch_add(cells, std::memory_order_relaxed);
+        update_max(max_opened_cells, cells);
+        update_max(max_open_depth, depth);
+    }
+
+    void count_adjacent_cell() {
+        adjacent_cells.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void report(std::ostream& os, bool json, const std::vector<CacheCounters>& caches) {
+        if (json) {
+            os << "{\"phases\":[";
+            for (int p = 0; p < (int)Phase::Count; p++) {
+                const PhaseStats& ps = phases[p];
+                os << (p ? "," : "") << "{\"name\":\"" << phase_names[p] << "\""
+                   << ",\"calls\":" << ps.calls.load()
+                   << ",\"total_ns\":" << ps.total_ns.load()
+                   << ",\"max_ns\":" << ps.max_ns.load()
+                   << ",\"histogram\":[";
+                bool first = true;
+                for (int k = 0; k < HISTOGRAM_BUCKETS; k++) {
+                    if (ps.histogram[k].load()) {
+                        os << (first ? "" : ",") << "{\"from_ns\":" << (1ull << k) << ",\"count\":" << ps.histogram[k].load() << "}";
+                        first = false;
+                    }
+                }
+                os << "]}";
+            }
+            os << "],\"do_open\":{\"cells\":" << opened_cells.load()
+               << ",\"max_cells\":" << max_opened_cells.load()
+               << ",\"max_depth\":" << max_open_depth.load() << "}"
+               << ",\"adjacent_cells\":" << adjacent_cells.load();
+            report_caches(os, json, caches);
+            os << "}" << std::endl;
+            return;
+        }
+
+        os << "Game statistics:\n";
+        os << std::left << std::setw(30) << "phase" << std::right
+           << std::setw(10) << "calls" << std::setw(14) << "total, us" << std::setw(12) << "mean, ns" << std::setw(12) << "max, ns" << "\n";
+        for (int p = 0; p < (int)Phase::Count; p++) {
+            const PhaseStats& ps = phases[p];
+            uint64_t calls = ps.calls.load();
+            os << std::left << std::setw(30) << phase_names[p] << std::right
+               << std::setw(10) << calls
+               << std::setw(14) << ps.total_ns.load() / 1000
+               << std::setw(12) << (calls ? ps.total_ns.load() / calls : 0)
+               << std::setw(12) << ps.max_ns.load() << "\n";
+        }
+        os << "do_open: " << opened_cells.load() << " cells opened, at most " << max_opened_cells.load()
+           << " per move, max recursion depth " << max_open_depth.load() << "\n";
+        os << "compute_adjacent_black_holes: " << adjacent_cells.load() << " cells\n";
+        for (int p = 0; p < (int)Phase::Count; p++) {
+            const PhaseStats& ps = phases[p];
+            if (!ps.calls.load()) {
+                continue;
+            }
+            os << "Latency histogram of " << phase_names[p] << ":\n";
+            for (int k = 0; k < HISTOGRAM_BUCKETS; k++) {
+                if (ps.histogram[k].load()) {
+                    os << "  >= " << std::setw(12) << (1ull << k) << " ns: " << ps.histogram[k].load() << "\n";
+                }
+            }
+        }
+        report_caches(os, json, caches);
+        os.flush();
+    }
+
+} // namespace GameStats
+
+#else
+
+namespace GameStats {
+
+    void report(std::ostream& os, bool json, const std::vector<CacheCounters>& caches) {
+        if (json) {
+            os << "{\"compiled\":false";
+            report_caches(os, json, caches);
+            os << "}" << std::endl;
+            return;
+        }
+        os << "Statistics are not compiled in, rebuild with: make STATS=1\n";
+        report_caches(os, json, caches);
+        os.flush();
+    }
+
+} // namespace GameStats
+
+#endif // GAME_STATS
@@ -0,0 +1,100 @@
+#ifndef GameStats_h
+#define GameStats_h
+
+//
+// Hot-path instrumentation: per-phase timers, call counters and latency histograms.
+// Everything compiles out unless the program is built with GAME_STATS defined (make STATS=1).
+//
+
+#ifdef GAME_STATS
+
+#include <chrono>
+#include <cstdint>
+
+namespace GameStats {
+
+    enum class Phase {
+        Setup,
+        AdjacentBlackHoles,
+        RegionIndex,
+        Open,
+        HiddenCells,
+        Randoms,
+        BlackHolesFromFile,
+        ShowGameBoard,
+        Snapshot,
+        Count
+    };
+
+    void record(Phase phase, uint64_t ns);
+    void record_open(uint64_t cells, uint64_t depth);
+    void count_adjacent_cell();
+
+    class ScopedTimer {
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+    public:
+        explicit ScopedTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            record(phase, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+    };
+
+    // Tracks one reveal through the do_open recursion: only the outermost call is timed
+    class OpenScope {
+        static thread_local uint64_t depth, max_depth, cells;
+        std::chrono::steady_clock::time_point start;
+    public:
+        OpenScope() {
+            if (0 == depth++) {
+                max_depth = cells = 0;
+                start = std::chrono::steady_clock::now();
+            }
+            if (depth > max_depth) {
+                max_depth = depth;
+            }
+        }
+        ~OpenScope() {
+            if (0 == --depth) {
+                record(Phase::Open, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+                record_open(cells, max_depth);
+            }
+        }
+        static void opened() { cells++; }
+        static void opened(uint64_t count) { cells += count; }
+    };
+
+} // namespace GameStats
+
+#define GAME_STATS_TIMER(phase)   GameStats::ScopedTimer game_stats_timer(GameStats::Phase::phase)
+#define GAME_STATS_OPEN_SCOPE()   GameStats::OpenScope game_stats_open_scope
+#define GAME_STATS_OPENED()       GameStats::OpenScope::opened()
+#define GAME_STATS_OPENED_CELLS(count) GameStats::OpenScope::opened((uint64_t)(count))
+#define GAME_STATS_ADJACENT()     GameStats::count_adjacent_cell()
+
+#else
+
+#define GAME_STATS_TIMER(phase)   ((void)0)
+#define GAME_STATS_OPEN_SCOPE()   ((void)0)
+#define GAME_STATS_OPENED()       ((void)0)
+#define GAME_STATS_OPENED_CELLS(count) ((void)0)
+#define GAME_STATS_ADJACENT()     ((void)0)
+
+#endif // GAME_STATS
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace GameStats {
+    // The counters of a cache, see TranspositionTable::counters
+    struct CacheCounters {
+        const char* name;
+        uint64_t    capacity, hits, misses, stores, replaced;
+    };
+
+    // Writes the collected statistics and the counters of the caches as text or as one JSON object (the caches in "caches")
+    void report(std::ostream& os, bool json, const std::vector<CacheCounters>& caches);
+}
+
+#endif // GameStats_h
@@ -0,0 +1,280 @@
+//
+// GameSweep.cpp
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameSweep.h"
+#include "GameController.h"
+#include "GameData.h"
+#include "GameHint.h"
+#include "Helpers.h"
+
+#define SWEEP_CHUNK_GAMES        10 // games of one configuration a thread takes at a time
+#define SWEEP_CHECKPOINT_SECONDS 10
+#define SWEEP_EXACT_NODES        (1 << 12) // steps of the exact count of the probabilities per guess
+
+namespace {
+
+    struct Configuration {
+        int n;
+        int holes;
+    };
+
+    // A chunk of games of one configuration, the unit of work
+    struct UnitResult {
+        int      unit;
+        int      wins;
+        uint64_t moves;
+        uint64_t ns;    // time of the thread that played the games
+    };
+
+    std::vector<Configuration> all_configurations() {
+        std::vector<Configuration> result;
+        for (int n = MIN_BOARD_SIZE; n <= MAX_BOARD_SIZE; n++) {
+            for (int holes = MIN_BLACK_HOLES; holes <= MAX_BLACK_HOLES(n); holes++) {
+                result.push_back({ n, holes });
+            }
+        }
+        return result;
+    }
+
+    // The black holes of the game: reproducible, so a resumed sweep plays the same games
+    std::vector<int> sweep_black_holes(const Configuration& config, int game) {
+        return seeded_black_holes(config.n * config.n, config.holes,
+                                  ((uint64_t)config.n << 48) | ((uint64_t)config.holes << 32) | (uint32_t)game);
+    }
+
+    /*
+        Function: play_game
+        Parameters:
+            board - the board set up for a new game
+            holes - the number of black holes on the board
+            moves - receives the number of cells clicked
+
+        Description: plays the game with the hint analysis: opens all the safe cells it finds in one batch,
+        if there are none it opens the cell least likely to be a black hole. The sweep keeps all threads busy
+        already, so the probabilities are counted exactly when it is cheap and never sampled.
+
+        Returns: MoveResult::Win or MoveResult::Lost
+    */
+    MoveResult play_game(GameBoard& board, int holes, int& moves) {
+        const std::atomic<bool> never_cancelled{ false };
+        GameHint::EstimateLimits limits;
+        limits.exact_nodes = SWEEP_EXACT_NODES;
+        limits.sample_ms = 0;
+        moves = 0;
+        for (;;) {
+            GameHint::Hint hint;
+            GameHint::analyze(GameHint::snapshot(board, holes), never_cancelled, hint, limits);
+            if (hint.safe.empty()) {
+                if (hint.guess_row < 0) { // Only black holes are closed, which is a win already
+                    return MoveResult::Win;
+                }
+                hint.safe.emplace_back(hint.guess_row, hint.guess_col);
+            }
+            // The cells opened by the area of a cell before are skipped
+            const MovesResult result = board.apply_moves(hint.safe);
+            moves += result.applied;
+            if (GameState::Play != result.state) {
+                return GameState::Win == result.state ? MoveResult::Win : MoveResult::Lost;
+            }
+        }
+    }
+
+    // Reads the units done from the checkpoint of the same sweep, each unit of the sweep once
+    std::vector<UnitResult> load_checkpoint(const char* checkpoint, int games, int units) {
+        std::vector<UnitResult> done;
+        std::ifstream in(checkpoint);
+        std::string tag;
+        int saved_games = 0, saved_chunk = 0, saved_units = 0;
+        if (!(in >> tag >> saved_games >> saved_chunk >> saved_units)) {
+            return done;
+        }
+        if ("sweep" != tag || saved_games != games || saved_chunk != SWEEP_CHUNK_GAMES || saved_units != units) {
+            std::cerr << "The checkpoint " << checkpoint << " is of another sweep, starting from scratch\n";
+            return done;
+        }
+        std::vector<char> seen(units, 0);
+        UnitResult r;
+        while (in >> r.unit >> r.wins >> r.moves >> r.ns) {
+            if (r.unit >= 0 && r.unit < units && !seen[r.unit]) {
+                seen[r.unit] = 1;
+                done.push_back(r);
+            }
+        }
+        return done;
+    }
+
+    // Writes a temporary file and renames it, so an interrupted write keeps the checkpoint before
+    void save_checkpoint(const char* checkpoint, int games, int units, const std::vector<UnitResult>& done) {
+        const std::string temporary = std::string(checkpoint) + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            out << "sweep " << games << " " << SWEEP_CHUNK_GAMES << " " << units << "\n";
+            for (const auto& r : done) {
+                out << r.unit << " " << r.wins << " " << r.moves << " " << r.ns << "\n";
+            }
+            if (!out) {
+                std::cerr << "Cannot write the checkpoint " << temporary << "\n";
+                return;
+            }
+        }
+        std::rename(temporary.c_str(), checkpoint);
+    }
+
+    void write_results(std::ostream& os, bool json, int games, const std::vector<Configuration>& configs,
+                       const std::vector<UnitResult>& done, int chunks) {
+        std::vector<int> wins(configs.size(), 0);
+        std::vector<uint64_t> moves(configs.size(), 0), ns(configs.size(), 0);
+        for (const auto& r : done) {
+            wins[r.unit / chunks] += r.wins;
+            moves[r.unit / chunks] += r.moves;
+            ns[r.unit / chunks] += r.ns;
+        }
+        if (json) {
+            os << "{\"games\":" << games << ",\"configurations\":[";
+        }
+        else {
+            os << "size,holes,games,wins,win_rate,moves_per_game,seconds,games_per_second\n";
+        }
+        for (size_t c = 0; c < configs.size(); c++) {
+            const double seconds = ns[c] / 1e9;
+            char line[256];
+            std::snprintf(line, sizeof(line), json
+                ? "%s{\"size\":%d,\"holes\":%d,\"games\":%d,\"wins\":%d,\"win_rate\":%.4f,\"moves_per_game\":%.2f,\"seconds\":%.6f,\"games_per_second\":%.1f}"
+                : "%s%d,%d,%d,%d,%.4f,%.2f,%.6f,%.1f\n",
+                (json && c) ? "," : "", configs[c].n, configs[c].holes, games, wins[c], wins[c] / (double)games,
+                moves[c] / (double)games, seconds, seconds > 0 ? games / seconds : 0.0);
+            os << line;
+        }
+        if (json) {
+            os << "]}\n";
+        }
+        os.flush();
+    }
+
+} // namespace
+
+/*
+    Function: RunSweep
+    Parameters:
+        filename - the file for the results, nullptr for stdout
+        json - write JSON instead of CSV
+        games - games of each configuration
+        checkpoint - the file of the progress
+
+    Description: the games of each configuration are split into units of SWEEP_CHUNK_GAMES games. The threads take
+    the next unit from a shared counter, so a thread stuck with large boards never holds up the others; the units
+    of the largest boards go first, so that the sweep does not end with one of them left running on a single thread.
+    The units done are saved to the checkpoint every SWEEP_CHECKPOINT_SECONDS, the units found in the checkpoint
+    are not played again. The checkpoint is removed when the results are written.
+
+    Returns: 0 on success, 1 if the results cannot be written
+*/
+int RunSweep(const char* filename, bool json, int games, const char* checkpoint) {
+    if (games < 1) {
+        std::cerr << "The number of games must be positive\n";
+        return 1;
+    }
+    const std::vector<Configuration> configs = all_configurations();
+    const int chunks = (games + SWEEP_CHUNK_GAMES - 1) / SWEEP_CHUNK_GAMES;
+    const int units = (int)configs.size() * chunks;
+
+    std::vector<UnitResult> done = load_checkpoint(checkpoint, games, units);
+    std::vector<char> is_done(units, 0);
+    for (const auto& r : done) {
+        is_done[r.unit] = 1;
+    }
+    std::vector<int> order;
+    for (int unit = 0; unit < units; unit++) {
+        if (!is_done[unit]) {
+            order.push_back(unit);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return configs[a / chunks].n > configs[b / chunks].n;
+    });
+    const size_t resumed = done.size();
+    if (resumed) {
+        std::cerr << "Resuming the sweep: " << done.size() << " of " << units << " units are done\n";
+    }
+
+    std::mutex              done_mutex;
+    std::condition_variable finished;
+    std::atomic<size_t>     next{ 0 };
+    int                     running = std::max(1u, std::thread::hardware_concurrency());
+    const auto start = std::chrono::steady_clock::now();
+
+    auto work = [&] {
+        for (size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < order.size(); ) {
+            const int unit = order[k];
+            const Configuration& config = configs[unit / chunks];
+            const int first = unit % chunks * SWEEP_CHUNK_GAMES,
+                      last = std::min(games, first + SWEEP_CHUNK_GAMES);
+            UnitResult r{ unit, 0, 0, 0 };
+            const auto unit_start = std::chrono::steady_clock::now();
+            auto board = make_game_board(config.n);
+            for (int game = first; game < last; game++) {
+                board->setup(config.n, sweep_black_holes(config, game));
+                int moves = 0;
+                r.wins += (MoveResult::Win == play_game(*board, config.holes, moves));
+                r.moves += moves;
+            }
+            r.ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - unit_start).count();
+            std::lock_guard<std::mutex> lock(done_mutex);
+            done.push_back(r);
+        }
+        std::lock_guard<std::mutex> lock(done_mutex);
+        running--;
+        finished.notify_one();
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = running; t > 0; t--) {
+        threads.emplace_back(work);
+    }
+    {
+        // The progress is copied under the lock and written without it, the threads never wait for the file
+        std::vector<UnitResult> progress;
+        std::unique_lock<std::mutex> lock(done_mutex);
+        while (!finished.wait_for(lock, std::chrono::seconds(SWEEP_CHECKPOINT_SECONDS), [&] { return 0 == running; })) {
+            progress = done;
+            lock.unlock();
+            save_checkpoint(checkpoint, games, units, progress);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cerr << "Sweep: " << progress.size() << " of " << units << " units done, "
+                << (int)((progress.size() - resumed) * SWEEP_CHUNK_GAMES / seconds) << " games per second\n";
+            lock.lock();
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::sort(done.begin(), done.end(), [](const UnitResult& a, const UnitResult& b) { return a.unit < b.unit; });
+    if (filename) {
+        std::ofstream out(filename, std::ios::trunc);
+        write_results(out, json, games, configs, done, chunks);
+        if (!out) {
+            std::cerr << "Cannot write the results to " << filename << "\n";
+            save_checkpoint(checkpoint, games, units, done);
+            return 1;
+        }
+    }
+    else {
+        write_results(std::cout, json, games, configs, done, chunks);
+    }
+    std::remove(checkpoint);
+    return 0;
+}
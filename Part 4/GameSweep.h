@@ -0,0 +1,16 @@
+#ifndef GameSweep_h
+#define GameSweep_h
+
+//
+// Parameter sweep: plays 'games' games of every board size MIN_BOARD_SIZE..MAX_BOARD_SIZE with every number
+// of black holes MIN_BLACK_HOLES..MAX_BLACK_HOLES(n) on all hardware threads, with the hint analysis as the player.
+// Writes the win rate and the throughput of each configuration as CSV (or JSON) to the file or stdout.
+// The progress is saved to the checkpoint file every few seconds, a sweep started again with the same
+// checkpoint goes on from there.
+//
+
+#define SWEEP_GAMES 100 // games of each configuration by default
+
+int RunSweep(const char* filename, bool json, int games, const char* checkpoint);
+
+#endif // GameSweep_h
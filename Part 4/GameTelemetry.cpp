@@ -0,0 +1,312 @@
+//
+// GameTelemetry.cpp
+//
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "GameTelemetry.h"
+#include "GameController.h"
+#include "GameData.h"
+
+#define TELEMETRY_CALIBRATION_US 2000 // start() measures the rate of the time stamp counter this long
+
+static_assert((TELEMETRY_RING_EVENTS & (TELEMETRY_RING_EVENTS - 1)) == 0, "The ring size must be a power of 2");
+
+namespace GameTelemetry {
+    std::atomic<bool> active{ false };
+}
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // The ring of a game thread: the thread writes the head, the writer writes the tail
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> head{ 0 };
+        uint64_t                          cached_tail = 0; // the tail as the game thread saw it last
+        alignas(64) std::atomic<uint64_t> tail{ 0 };
+        alignas(64) std::atomic<uint64_t> dropped{ 0 };
+        uint32_t                          thread = 0;
+        TelemetryEvent                    events[TELEMETRY_RING_EVENTS];
+    };
+
+    std::mutex                          rings_mutex;
+    std::vector<std::unique_ptr<Ring>>  rings;       // of all threads that pushed, until stop()
+    std::atomic<uint32_t>               generation{ 0 }; // of start(), the rings of an earlier run are gone
+    thread_local Ring*                  local_ring = nullptr;
+    thread_local uint32_t               local_generation = 0;
+    std::atomic<uint32_t>               games{ 0 };
+
+    uint64_t                            origin = 0;      // ticks
+    double                              ns_per_tick = 1;
+    GameTelemetry::Format               format = GameTelemetry::Format::Binary;
+    GameTelemetry::Overflow             overflow = GameTelemetry::Overflow::Drop;
+    std::FILE*                          file = nullptr;
+    std::thread                         writer;
+    bool                                writing = false;
+    std::mutex                          writer_mutex;
+    std::condition_variable             wake;
+    std::atomic<bool>                   flush_requested{ false }; // a ring is past its high water mark
+
+#if defined(__x86_64__) || defined(__i386__)
+    // The time stamp counter runs at a constant rate on the CPUs of today and costs about half a steady_clock read
+    uint64_t ticks() {
+        return __rdtsc();
+    }
+    constexpr bool tick_counter = true;
+#else
+    uint64_t ticks() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+    constexpr bool tick_counter = false;
+#endif
+
+    uint64_t nanoseconds(uint64_t ticks) {
+        return (uint64_t)(ticks * ns_per_tick);
+    }
+
+    // Wakes the writer up before the end of its period, once until it drains the rings
+    void request_flush() {
+        if (!flush_requested.load(std::memory_order_relaxed) && !flush_requested.exchange(true)) {
+            { // The writer is either before its wait, and sees the flag, or in it, and gets the notification
+                std::lock_guard<std::mutex> lock(writer_mutex);
+            }
+            wake.notify_one();
+        }
+    }
+
+    // The ring of this thread, made on the first push of the thread
+    Ring* thread_ring() {
+        const uint32_t current = generation.load(std::memory_order_acquire);
+        if (local_generation != current) {
+            auto ring = std::make_unique<Ring>();
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            ring->thread = (uint32_t)rings.size();
+            local_ring = ring.get();
+            local_generation = current;
+            rings.push_back(std::move(ring));
+        }
+        return local_ring;
+    }
+
+    void push(TelemetryEvent& event) {
+        Ring* ring = thread_ring();
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        if (head - ring->cached_tail >= TELEMETRY_HIGH_WATER) { // The slow path: the ring may be filling up
+            ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+            if (head - ring->cached_tail >= TELEMETRY_HIGH_WATER) {
+                request_flush();
+            }
+            while (head - ring->cached_tail == TELEMETRY_RING_EVENTS) {
+                if (GameTelemetry::Overflow::Drop == overflow) {
+                    ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+                ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+            }
+        }
+        event.thread = ring->thread;
+        ring->events[head & (TELEMETRY_RING_EVENTS - 1)] = event;
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    void append_jsonl(std::string& out, const TelemetryEvent& e) {
+        char line[256];
+        switch ((TelemetryKind)e.kind) {
+        case TelemetryKind::GameStart:
+            std::snprintf(line, sizeof(line), "{\"time\":%llu,\"thread\":%u,\"game\":%u,\"event\":\"game_start\",\"size\":%u,\"black_holes\":%u}\n",
+                (unsigned long long)e.time, e.thread, e.game, e.size, e.value);
+            break;
+        case TelemetryKind::Move:
+            std::snprintf(line, sizeof(line), "{\"time\":%llu,\"thread\":%u,\"game\":%u,\"event\":\"move\",\"size\":%u,\"row\":%d,\"col\":%d,"
+                "\"result\":\"%s\",\"opened\":%u,\"ns\":%u}\n",
+                (unsigned long long)e.time, e.thread, e.game, e.size, e.row, e.col, move_result_name((MoveResult)e.result), e.value, e.ns);
+            break;
+        case TelemetryKind::GameEnd:
+            std::snprintf(line, sizeof(line), "{\"time\":%llu,\"thread\":%u,\"game\":%u,\"event\":\"game_end\",\"size\":%u,\"won\":%s,\"hidden\":%u}\n",
+                (unsigned long long)e.time, e.thread, e.game, e.size, e.result ? "true" : "false", e.value);
+            break;
+        default:
+            std::snprintf(line, sizeof(line), "{\"time\":%llu,\"thread\":%u,\"event\":\"dropped\",\"count\":%u}\n",
+                (unsigned long long)e.time, e.thread, e.value);
+            break;
+        }
+        out += line;
+    }
+
+    // The event with its times in nanoseconds
+    void append(std::string& out, TelemetryEvent event) {
+        event.time = nanoseconds(event.time);
+        event.ns = (uint32_t)std::min<uint64_t>(nanoseconds(event.ns), UINT32_MAX);
+        if (GameTelemetry::Format::Jsonl == format) {
+            append_jsonl(out, event);
+        }
+        else {
+            out.append(reinterpret_cast<const char*>(&event), sizeof(event));
+        }
+    }
+
+    // Moves the events of all rings into the file
+    void drain(std::string& out) {
+        std::vector<Ring*> current;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            for (const auto& ring : rings) {
+                current.push_back(ring.get());
+            }
+        }
+        for (Ring* ring : current) {
+            const uint64_t head = ring->head.load(std::memory_order_acquire),
+                           tail = ring->tail.load(std::memory_order_relaxed);
+            for (uint64_t i = tail; i < head; i++) {
+                append(out, ring->events[i & (TELEMETRY_RING_EVENTS - 1)]);
+            }
+            ring->tail.store(head, std::memory_order_release);
+        }
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), file);
+            out.clear();
+        }
+    }
+
+    void write_events() {
+        std::string out;
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        while (writing) {
+            wake.wait_for(lock, std::chrono::milliseconds(TELEMETRY_FLUSH_MS), [] { return !writing || flush_requested.load(); });
+            flush_requested.store(false);
+            lock.unlock();
+            drain(out);
+            lock.lock();
+        }
+    }
+
+} // namespace
+
+/*
+    Function: GameTelemetry::start
+    Parameters:
+        filename - the file of the events
+        format - raw records or JSON lines
+        overflow - what a game thread does when its ring is full
+
+    Description: creates the file, writes the header of the binary format, measures the rate of the time stamp
+    counter against steady_clock for TELEMETRY_CALIBRATION_US and starts the writer thread.
+    The rings of the game threads are made on their first event.
+
+    Returns: false if the file cannot be created or the telemetry runs already
+*/
+bool GameTelemetry::start(const std::string& filename, Format new_format, Overflow new_overflow) {
+    if (active.load() || !(file = std::fopen(filename.c_str(), "wb"))) {
+        return false;
+    }
+    format = new_format;
+    overflow = new_overflow;
+    if (Format::Binary == format) {
+        const TelemetryHeader header{ TELEMETRY_MAGIC, TELEMETRY_VERSION, (uint32_t)sizeof(TelemetryEvent), 0 };
+        std::fwrite(&header, sizeof(header), 1, file);
+    }
+    const auto calibration = Clock::now();
+    origin = ticks();
+    if (tick_counter) {
+        while (Clock::now() - calibration < std::chrono::microseconds(TELEMETRY_CALIBRATION_US)) {
+        }
+        ns_per_tick = std::chrono::duration<double, std::nano>(Clock::now() - calibration).count() / (double)(ticks() - origin);
+    }
+    flush_requested.store(false);
+    generation.fetch_add(1, std::memory_order_release);
+    writing = true;
+    writer = std::thread(write_events);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+void GameTelemetry::stop() {
+    if (!active.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        writing = false;
+    }
+    wake.notify_one();
+    writer.join();
+
+    std::string out;
+    drain(out); // The events pushed since the last flush
+    const uint64_t lost = dropped();
+    for (const auto& ring : rings) {
+        const uint64_t count = ring->dropped.load(std::memory_order_relaxed);
+        if (count) {
+            TelemetryEvent event{};
+            event.time = now();
+            event.thread = ring->thread;
+            event.kind = (uint8_t)TelemetryKind::Dropped;
+            event.value = (uint32_t)std::min<uint64_t>(count, UINT32_MAX);
+            append(out, event);
+        }
+    }
+    std::fwrite(out.data(), 1, out.size(), file);
+    std::fclose(file);
+    file = nullptr;
+    rings.clear();
+    if (lost) {
+        std::cerr << "Telemetry: " << lost << " events dropped, the rings were full\n";
+    }
+}
+
+uint64_t GameTelemetry::now() {
+    return ticks() - origin;
+}
+
+void GameTelemetry::game_start(GameBoard& board, int black_holes) {
+    board.set_game_number(games.fetch_add(1, std::memory_order_relaxed) + 1);
+    TelemetryEvent event{};
+    event.time = now();
+    event.game = board.game_number();
+    event.kind = (uint8_t)TelemetryKind::GameStart;
+    event.size = (uint16_t)board.board_size();
+    event.value = (uint32_t)black_holes;
+    push(event);
+}
+
+void GameTelemetry::move(const GameBoard& board, int row, int col, MoveResult result, int opened, uint64_t start, uint64_t end) {
+    TelemetryEvent event{};
+    event.time = end;
+    event.game = board.game_number();
+    event.kind = (uint8_t)TelemetryKind::Move;
+    event.result = (uint8_t)result;
+    event.size = (uint16_t)board.board_size();
+    event.row = (int16_t)row;
+    event.col = (int16_t)col;
+    event.value = (uint32_t)opened;
+    event.ns = (uint32_t)std::min<uint64_t>(end - start, UINT32_MAX);
+    push(event);
+    if (MoveResult::Win == result || MoveResult::Lost == result) {
+        event.kind = (uint8_t)TelemetryKind::GameEnd;
+        event.result = MoveResult::Win == result;
+        event.value = (uint32_t)board.hidden_cells();
+        push(event);
+    }
+}
+
+uint64_t GameTelemetry::dropped() {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    uint64_t count = 0;
+    for (const auto& ring : rings) {
+        count += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return count;
+}
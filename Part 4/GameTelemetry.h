@@ -0,0 +1,97 @@
+#ifndef GameTelemetry_h
+#define GameTelemetry_h
+
+//
+// Telemetry of the games: every game thread pushes fixed-size event records into a ring buffer of its own
+// (single producer, single consumer, no locks), a background writer drains the rings into a file every
+// TELEMETRY_FLUSH_MS, as the raw records or as JSON lines. A thread whose ring fills past TELEMETRY_HIGH_WATER
+// wakes the writer up before its time. The game thread never waits for the file: when its ring is full
+// the event is dropped and counted (Overflow::Drop), or the thread waits for the writer (Overflow::Block).
+// The drops of each thread are written at the end, as Dropped records.
+//
+// With the telemetry off the hooks cost a relaxed load and a branch; with it on, a push is two reads of the
+// time stamp counter (of steady_clock where there is none) and a 32-byte store into the ring. The writer turns
+// the ticks into nanoseconds with the rate of the counter measured by start().
+//
+// The binary file starts with the TelemetryHeader, TelemetryEvent records follow in the native byte order.
+//
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define TELEMETRY_RING_EVENTS 131072 // events in the ring of a thread, a power of 2: more than a flush period of moves (4 MB)
+#define TELEMETRY_HIGH_WATER  (TELEMETRY_RING_EVENTS / 2) // a ring this full wakes the writer up
+#define TELEMETRY_FLUSH_MS    10    // the writer drains the rings this often
+#define TELEMETRY_MAGIC       0x4C545850u // "PXTL"
+#define TELEMETRY_VERSION     1
+
+class GameBoard;
+enum class MoveResult;
+
+enum class TelemetryKind : uint8_t {
+    GameStart, // value - black holes
+    Move,      // row, col, result - MoveResult, value - cells opened, ns - the time of the move
+    GameEnd,   // result - 1 won, 0 lost, value - hidden cells left
+    Dropped    // value - events of the thread dropped because its ring was full
+};
+
+struct TelemetryEvent {
+    uint64_t time;   // nanoseconds since the telemetry started
+    uint32_t thread; // the number of the ring of the game thread
+    uint32_t game;   // the number of the game, see GameBoard::game_number
+    uint8_t  kind;   // TelemetryKind
+    uint8_t  result;
+    uint16_t size;   // board size
+    int16_t  row;
+    int16_t  col;
+    uint32_t value;
+    uint32_t ns;
+};
+static_assert(sizeof(TelemetryEvent) == 32, "The records of the binary file are 32 bytes");
+
+struct TelemetryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t event_size;
+    uint32_t reserved;
+};
+
+namespace GameTelemetry {
+
+    enum class Format {
+        Binary,
+        Jsonl
+    };
+
+    enum class Overflow {
+        Drop,  // a full ring drops the new event and counts it
+        Block  // a full ring makes the game thread wait for the writer
+    };
+
+    extern std::atomic<bool> active;
+
+    inline bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // Opens the file and starts the writer, returns false if the file cannot be created
+    bool start(const std::string& filename, Format format, Overflow overflow);
+
+    // Drains the rings, writes the drop counters and closes the file. Call it once the game threads stop pushing.
+    void stop();
+
+    // The clock of the events: ticks since the telemetry started, written as nanoseconds
+    uint64_t now();
+
+    // The events of the game threads, call them only if enabled().
+    // The move took from start to end (see now()), end is the time of its event.
+    void game_start(GameBoard& board, int black_holes);
+    void move(const GameBoard& board, int row, int col, MoveResult result, int opened, uint64_t start, uint64_t end);
+
+    // Events dropped by all threads so far
+    uint64_t dropped();
+
+} // namespace GameTelemetry
+
+#endif // GameTelemetry_h
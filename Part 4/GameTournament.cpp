@@ -0,0 +1,365 @@
+//
+// GameTournament.cpp
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "GameTournament.h"
+#include "GameData.h"
+#include "GameHint.h"
+#include "Helpers.h"
+
+namespace {
+
+    using Cells = std::vector<std::pair<int, int>>;
+
+    // A player: chooses the cells to open in the visible position, they are opened as one batch (see apply_moves)
+    typedef void (*Strategy)(const GameHint::BoardView& view, std::mt19937_64& rgen, Cells& moves);
+
+    // The safe cells of the hint analysis, or its best guess. The strategies play on all threads already,
+    // so the analysis never samples: the probabilities are counted exactly or guessed (see GameHint::analyze).
+    void play_hint(const GameHint::BoardView& view, const GameHint::EstimateLimits& limits, Cells& moves) {
+        static const std::atomic<bool> never_cancelled{ false };
+        GameHint::Hint hint;
+        GameHint::analyze(view, never_cancelled, hint, limits);
+        moves = hint.safe;
+        if (moves.empty() && hint.guess_row >= 0) {
+            moves.emplace_back(hint.guess_row, hint.guess_col);
+        }
+    }
+
+    void play_exact(const GameHint::BoardView& view, std::mt19937_64&, Cells& moves) {
+        GameHint::EstimateLimits limits;
+        limits.sample_ms = 0;
+        play_hint(view, limits, moves);
+    }
+
+    void play_heuristic(const GameHint::BoardView& view, std::mt19937_64&, Cells& moves) {
+        GameHint::EstimateLimits limits;
+        limits.exact_nodes = 0;
+        limits.sample_ms = 0;
+        play_hint(view, limits, moves);
+    }
+
+    // Any closed cell
+    void play_blind(const GameHint::BoardView& view, std::mt19937_64& rgen, Cells& moves) {
+        std::vector<int> closed;
+        for (auto i = 0; i < (int)view.cells.size(); i++) {
+            if (view.cells[i] < 0) {
+                closed.push_back(i);
+            }
+        }
+        moves.clear();
+        if (!closed.empty()) {
+            const int i = closed[rgen() % closed.size()];
+            moves.emplace_back(i / view.n, i % view.n);
+        }
+    }
+
+    // The safe cells of the hint analysis, otherwise any closed cell not known to be a black hole
+    void play_safe_random(const GameHint::BoardView& view, std::mt19937_64& rgen, Cells& moves) {
+        static const std::atomic<bool> never_cancelled{ false };
+        GameHint::EstimateLimits limits;
+        limits.exact_nodes = 0;
+        limits.sample_ms = 0;
+        GameHint::Hint hint;
+        GameHint::analyze(view, never_cancelled, hint, limits);
+        moves = hint.safe;
+        if (moves.empty()) {
+            GameHint::BoardView unknown = view;
+            for (const auto& h : hint.holes) {
+                unknown.cells[h.first * view.n + h.second] = 0; // Not a candidate
+            }
+            play_blind(unknown, rgen, moves);
+        }
+    }
+
+    struct StrategyInfo {
+        const char* name;
+        Strategy    play;
+    };
+
+    const StrategyInfo all_strategies[] = {
+        { "exact",       play_exact },       // safe cells, else the guess by the exact probabilities
+        { "heuristic",   play_heuristic },   // safe cells, else the guess by the ratios of the numbers
+        { "safe-random", play_safe_random }, // safe cells, else a random cell
+        { "blind",       play_blind }        // a random cell
+    };
+
+    struct Board {
+        int              n;
+        std::vector<int> holes;
+    };
+
+    bool load_boards(const TournamentBoards& spec, std::vector<Board>& boards) {
+        if (spec.corpus.empty()) {
+            if (spec.size < MIN_BOARD_SIZE || spec.black_holes < MIN_BLACK_HOLES || spec.black_holes > MAX_BLACK_HOLES(spec.size) || spec.seeds < 1) {
+                std::cerr << "The boards of the tournament are not valid\n";
+                return false;
+            }
+            for (int s = 0; s < spec.seeds; s++) {
+                boards.push_back({ spec.size, TournamentBlackHoles(spec, spec.first_seed + (uint64_t)s) });
+            }
+            return true;
+        }
+        std::ifstream in(spec.corpus);
+        std::string file;
+        while (std::getline(in, file)) {
+            if (file.empty()) {
+                continue;
+            }
+            unsigned int n = 0;
+            std::vector<int> holes = black_holes_from_file(file.c_str(), n);
+            const bool on_board = std::all_of(holes.begin(), holes.end(), [n](int i) { return 0 <= i && i < (int)(n * n); });
+            if (n < MIN_BOARD_SIZE || holes.empty() || (int)holes.size() > MAX_BLACK_HOLES((int)n) || !on_board) {
+                std::cerr << "The board " << file << " of the corpus is not valid\n";
+                return false;
+            }
+            boards.push_back({ (int)n, holes });
+        }
+        if (boards.empty()) {
+            std::cerr << "The corpus " << spec.corpus << " has no boards\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool parse_strategies(const std::string& list, std::vector<int>& chosen) {
+        const int count = (int)(sizeof(all_strategies) / sizeof(all_strategies[0]));
+        if (list.empty()) {
+            for (int s = 0; s < count; s++) {
+                chosen.push_back(s);
+            }
+            return true;
+        }
+        size_t from = 0;
+        while (from <= list.size()) {
+            const size_t comma = std::min(list.find(',', from), list.size());
+            const std::string name = list.substr(from, comma - from);
+            int s = 0;
+            while (s < count && name != all_strategies[s].name) {
+                s++;
+            }
+            if (s == count) {
+                std::cerr << "Unknown strategy " << name << ", the strategies are " << TournamentStrategies() << "\n";
+                return false;
+            }
+            chosen.push_back(s);
+            from = comma + 1;
+        }
+        return true;
+    }
+
+    /*
+        Function: play_game
+        Parameters:
+            board - the board set up for the game
+            holes - the number of black holes on it
+            strategy - the player
+            rgen - the random numbers of the player
+            latencies - receives the nanoseconds of each decision
+            moves - receives the number of cells clicked
+
+        Description: asks the strategy for the cells to open and opens them until the game is over.
+        A strategy that opens nothing, e.g. only cells opened already, loses the game.
+
+        Returns: true if the game is won
+    */
+    bool play_game(GameBoard& board, int holes, Strategy strategy, std::mt19937_64& rgen, std::vector<uint32_t>& latencies, int& moves) {
+        Cells cells;
+        moves = 0;
+        for (;;) {
+            const GameHint::BoardView view = GameHint::snapshot(board, holes);
+            const auto start = std::chrono::steady_clock::now();
+            strategy(view, rgen, cells);
+            latencies.push_back((uint32_t)std::min<int64_t>(UINT32_MAX,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+            const MovesResult result = board.apply_moves(cells);
+            moves += result.applied;
+            if (GameState::Play != result.state) {
+                return GameState::Win == result.state;
+            }
+            if (0 == result.applied) {
+                return false;
+            }
+        }
+    }
+
+    // The value at the fraction q of the sorted values
+    double percentile(const std::vector<uint32_t>& sorted, double q) {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, (size_t)(q * sorted.size()))];
+    }
+
+    struct Pair {
+        int    a, b;
+        int    only_a = 0; // boards won by a and lost by b
+        int    only_b = 0;
+        double difference = 0; // of the win rates, a - b
+        double error = 0;      // half-width of its 95% confidence interval
+        double p_value = 1;    // of McNemar's test
+    };
+
+    /*
+        Function: compare
+        Parameters:
+            wins - for each board, whether each strategy won it
+            pair - the strategies a and b to compare, receives the statistics
+
+        Description: the paired difference of the boards is +1 if only a won, -1 if only b won, 0 otherwise.
+        Its mean is the difference of the win rates, the normal approximation gives the confidence interval.
+        McNemar's test (with the continuity correction) looks at the discordant boards only:
+        chi^2 = (|only_a - only_b| - 1)^2 / (only_a + only_b) with one degree of freedom.
+
+        Returns: void
+    */
+    void compare(const std::vector<std::vector<char>>& wins, Pair& pair) {
+        for (const auto& board : wins) {
+            pair.only_a += board[pair.a] && !board[pair.b];
+            pair.only_b += board[pair.b] && !board[pair.a];
+        }
+        const double games = (double)wins.size();
+        pair.difference = (pair.only_a - pair.only_b) / games;
+        const double variance = ((pair.only_a + pair.only_b) / games - pair.difference * pair.difference) * games / std::max(1.0, games - 1);
+        pair.error = 1.96 * std::sqrt(std::max(0.0, variance) / games);
+        const int discordant = pair.only_a + pair.only_b;
+        if (discordant > 0) {
+            const double d = std::max(0.0, std::abs(pair.only_a - pair.only_b) - 1.0);
+            pair.p_value = std::erfc(std::sqrt(d * d / discordant / 2));
+        }
+    }
+
+} // namespace
+
+std::string TournamentStrategies() {
+    std::string names;
+    for (const auto& s : all_strategies) {
+        names += (names.empty() ? "" : ",") + std::string(s.name);
+    }
+    return names;
+}
+
+// The boards of the seeds are reproducible, like the boards of the sweep
+std::vector<int> TournamentBlackHoles(const TournamentBoards& spec, uint64_t seed) {
+    return seeded_black_holes(spec.size * spec.size, spec.black_holes, seed);
+}
+
+/*
+    Function: RunTournament
+    Parameters:
+        filename - the file for the report, nullptr for stdout
+        json - write JSON instead of text
+        spec - the boards
+        strategies - comma separated names, empty for all
+
+    Description: the threads take the next board from a shared counter and play it with every strategy,
+    each game on a board of its own. The random numbers of a strategy depend on the board only, so the tournament
+    is reproducible for the strategies that do not depend on time. Then the win rates and the percentiles of the
+    decision times of each strategy are reported, and each pair of strategies is compared (see compare).
+
+    Returns: 0 on success, 1 if the boards or the strategies are not valid or the report cannot be written
+*/
+int RunTournament(const char* filename, bool json, const TournamentBoards& spec, const std::string& strategies) {
+    std::vector<Board> boards;
+    std::vector<int> chosen;
+    if (!load_boards(spec, boards) || !parse_strategies(strategies, chosen)) {
+        return 1;
+    }
+    const int count = (int)chosen.size();
+
+    std::vector<std::vector<char>> wins(boards.size(), std::vector<char>(count, 0));
+    std::vector<std::vector<uint32_t>> latencies(count);
+    std::vector<uint64_t> moves(count, 0);
+    std::mutex merge_mutex;
+    std::atomic<size_t> next{ 0 };
+    auto work = [&] {
+        std::vector<std::vector<uint32_t>> local(count);
+        std::vector<uint64_t> local_moves(count, 0);
+        for (size_t b; (b = next.fetch_add(1, std::memory_order_relaxed)) < boards.size(); ) {
+            for (int s = 0; s < count; s++) {
+                auto board = make_game_board(boards[b].n);
+                board->setup(boards[b].n, boards[b].holes);
+                std::mt19937_64 rgen(zobrist_mix(b));
+                int played = 0;
+                wins[b][s] = play_game(*board, (int)boards[b].holes.size(), all_strategies[chosen[s]].play, rgen, local[s], played);
+                local_moves[s] += played;
+            }
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        for (int s = 0; s < count; s++) {
+            latencies[s].insert(latencies[s].end(), local[s].begin(), local[s].end());
+            moves[s] += local_moves[s];
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = std::max(1u, std::thread::hardware_concurrency()); t > 0; t--) {
+        threads.emplace_back(work);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::ofstream file;
+    if (filename) {
+        file.open(filename, std::ios::trunc);
+    }
+    std::ostream& os = filename ? file : std::cout;
+    const double games = (double)boards.size();
+    char line[512];
+    os << (json ? "{\"boards\":" : "Boards: ") << boards.size() << (json ? ",\"strategies\":[" : "\n");
+    if (!json) {
+        std::snprintf(line, sizeof(line), "%-12s %8s %9s %8s %10s %10s %10s %10s %10s\n",
+            "strategy", "wins", "win_rate", "moves", "decisions", "p50_us", "p90_us", "p99_us", "max_us");
+        os << line;
+    }
+    for (int s = 0; s < count; s++) {
+        std::sort(latencies[s].begin(), latencies[s].end());
+        int won = 0;
+        for (const auto& board : wins) {
+            won += board[s];
+        }
+        std::snprintf(line, sizeof(line), json
+            ? "%s{\"name\":\"%s\",\"wins\":%d,\"win_rate\":%.4f,\"moves_per_game\":%.2f,\"decisions\":%zu,\"p50_us\":%.1f,\"p90_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}"
+            : "%s%-12s %8d %9.4f %8.2f %10zu %10.1f %10.1f %10.1f %10.1f\n",
+            (json && s) ? "," : "", all_strategies[chosen[s]].name, won, won / games, moves[s] / games, latencies[s].size(),
+            percentile(latencies[s], 0.5) / 1e3, percentile(latencies[s], 0.9) / 1e3, percentile(latencies[s], 0.99) / 1e3,
+            latencies[s].empty() ? 0.0 : latencies[s].back() / 1e3);
+        os << line;
+    }
+    os << (json ? "],\"pairs\":[" : "\nPaired differences of the win rates (a - b):\n");
+    if (!json) {
+        std::snprintf(line, sizeof(line), "%-12s %-12s %8s %8s %10s %10s %10s\n", "a", "b", "only_a", "only_b", "difference", "ci95", "p_value");
+        os << line;
+    }
+    bool first = true;
+    for (int a = 0; a < count; a++) {
+        for (int b = a + 1; b < count; b++) {
+            Pair pair{ a, b };
+            compare(wins, pair);
+            std::snprintf(line, sizeof(line), json
+                ? "%s{\"a\":\"%s\",\"b\":\"%s\",\"only_a\":%d,\"only_b\":%d,\"difference\":%.4f,\"ci95\":%.4f,\"p_value\":%.3g}"
+                : "%s%-12s %-12s %8d %8d %+10.4f %10.4f %10.3g\n",
+                (json && !first) ? "," : "", all_strategies[chosen[a]].name, all_strategies[chosen[b]].name,
+                pair.only_a, pair.only_b, pair.difference, pair.error, pair.p_value);
+            os << line;
+            first = false;
+        }
+    }
+    if (json) {
+        os << "]}\n";
+    }
+    os.flush();
+    if (!os) {
+        std::cerr << "Cannot write the results to " << (filename ? filename : "stdout") << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef GameTournament_h
+#define GameTournament_h
+
+//
+// Paired tournament: every strategy plays every board of the corpus (or of a range of seeds), each on its own board,
+// the boards are shared out between all hardware threads. Since the strategies play the same boards, their win rates
+// are compared game by game: the paired difference with its 95% confidence interval and the p-value of McNemar's test.
+// The time of each decision is measured too, the report gives its percentiles for each strategy.
+//
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define TOURNAMENT_SEEDS       1000 // boards of the seed range by default
+#define TOURNAMENT_BOARD_SIZE  16   // the boards of the seed range by default
+#define TOURNAMENT_BLACK_HOLES 40
+
+struct TournamentBoards {
+    std::string corpus;                            // a file with a board file name on each line, like for -f
+    unsigned    first_seed = 0;                    // otherwise the boards of the seeds first_seed..first_seed + seeds - 1
+    int         seeds = TOURNAMENT_SEEDS;
+    int         size = TOURNAMENT_BOARD_SIZE;
+    int         black_holes = TOURNAMENT_BLACK_HOLES;
+};
+
+// The black holes of the board of the seed, of spec.size and spec.black_holes
+std::vector<int> TournamentBlackHoles(const TournamentBoards& spec, uint64_t seed);
+
+// The names of the strategies, for the help
+std::string TournamentStrategies();
+
+// 'strategies' is a comma separated list of names, empty for all strategies.
+// Returns 0 on success, 1 if the boards or the strategies are not valid or the results cannot be written.
+int RunTournament(const char* filename, bool json, const TournamentBoards& boards, const std::string& strategies);
+
+#endif // GameTournament_h
@@ -4,18 +4,153 @@
 // The simplest UI implementation
 //
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <string>
 
 #include "GameUI.h"
 #include "GameData.h"
+#include "GameHint.h"
 
 #define CELL_CLOSED '#'
 #define CELL_HOLE   'H'
 
+// Boards larger than the viewport show VIEW_ROWS x VIEW_COLS cells and an overview of the board around them
+#define VIEW_ROWS     20
+#define VIEW_COLS     32
+#define OVERVIEW_ROWS 16
+#define OVERVIEW_COLS 64
+
+// A block of the overview
+#define BLOCK_CLOSED '#' // no cell opened
+#define BLOCK_SOME   '+' // at most half of the cells opened
+#define BLOCK_MOST   '-' // more than half of the cells opened
+#define BLOCK_OPENED '.' // all cells opened
+#define BLOCK_HOLES  'h' // black holes opened, up to a fifth of the cells
+#define BLOCK_DENSE  'H' // black holes opened, more than a fifth of the cells
+
 
 namespace GameUI {
 
+    namespace {
+
+        bool fits_viewport(const GameBoard* board) {
+            return board->board_size() <= VIEW_ROWS && board->board_size() <= VIEW_COLS;
+        }
+
+        // The finest level at which the overview shows the whole board
+        int fit_level(const TileCounts& tiles) {
+            int level = 0;
+            while (level + 1 < tiles.levels()
+                   && (tiles.blocks_per_side(level) > OVERVIEW_ROWS || tiles.blocks_per_side(level) > OVERVIEW_COLS)) {
+                level++;
+            }
+            return level;
+        }
+
+        // Moves the viewport inside the board and resolves its level
+        void clamp_viewport(const GameBoard* board, Viewport& view) {
+            const int n = board->board_size();
+            view.top = std::max(0, std::min(view.top, n - VIEW_ROWS));
+            view.left = std::max(0, std::min(view.left, n - VIEW_COLS));
+            const TileCounts& tiles = board->tile_counts();
+            view.level = view.level < 0 ? fit_level(tiles) : std::min(view.level, tiles.levels() - 1);
+        }
+
+        char block_glyph(const TileCounts::Block& block) {
+            if (block.holes) {
+                return block.holes * 5 <= block.cells ? BLOCK_HOLES : BLOCK_DENSE;
+            }
+            if (0 == block.opened) {
+                return BLOCK_CLOSED;
+            }
+            if (block.opened == block.cells) {
+                return BLOCK_OPENED;
+            }
+            return block.opened * 2 <= block.cells ? BLOCK_SOME : BLOCK_MOST;
+        }
+
+        /*
+            Function: showViewport
+            Parameters:
+                board - a board larger than the viewport
+                debug_mode - show all the cells of the viewport next to it
+                view - the viewport
+
+            Description: shows the cells of the viewport, then the overview of the board around it, one character
+            for a block of tiles drawn from the tile counts. The rows and the columns of the overview that cover
+            the viewport are marked. The cost depends on the size of the viewport and the overview, not of the board.
+
+            Returns: void
+        */
+        void showViewport(const GameBoard* board, bool debug_mode, Viewport& view) {
+            clamp_viewport(board, view);
+            const int n = board->board_size();
+            const int rows = std::min(n, VIEW_ROWS),
+                      cols = std::min(n, VIEW_COLS);
+            const int width = (int)std::to_string(n).size();
+            std::cout << "Rows " << view.top + 1 << "-" << view.top + rows << ", columns " << view.left + 1 << "-"
+                << view.left + cols << " of " << n << ":\n";
+
+            int cnt = debug_mode ? 2 : 1;
+            for (auto i = 0; i < cnt; i++) { // The last digit of the column
+                std::cout << std::setw(width + 1) << "";
+                for (auto col = view.left; col < view.left + cols; col++) {
+                    std::cout << " " << (col + 1) % 10;
+                }
+                std::cout << "  ";
+            }
+            std::cout << std::endl;
+            const bool hex = BoardTopology::Hex == board->topology();
+            for (auto row = view.top; row < view.top + rows; row++) {
+                const bool shifted = hex && (row & 1);
+                for (auto i = 0; i < cnt; i++) {
+                    std::cout << std::setw(width) << row + 1 << "|" << (shifted ? " " : "");
+                    for (auto col = view.left; col < view.left + cols; col++) {
+                        char cell = CELL_CLOSED;
+                        if (i || board->is_opened_cell(row, col)) {
+                            cell = board->is_black_hole_cell(row, col) ? CELL_HOLE : '0' + board->black_holes_nearby(row, col);
+                        }
+                        std::cout << " " << cell;
+                    }
+                    std::cout << (hex && !shifted ? "  |" : " |");
+                }
+                std::cout << std::endl;
+            }
+
+            const TileCounts& tiles = board->tile_counts();
+            const int side = tiles.blocks_per_side(view.level),
+                      size = tiles.block_cells(view.level);
+            const int block_rows = std::min(side, OVERVIEW_ROWS),
+                      block_cols = std::min(side, OVERVIEW_COLS);
+            // Centered on the viewport
+            const int top = std::max(0, std::min((view.top + rows / 2) / size - block_rows / 2, side - block_rows)),
+                      left = std::max(0, std::min((view.left + cols / 2) / size - block_cols / 2, side - block_cols));
+            auto covers = [size](int block, int first, int count) {
+                return block * size < first + count && first < (block + 1) * size;
+            };
+            std::cout << "Overview, a character for " << size << "x" << size << " cells ('" << BLOCK_CLOSED << "' closed, '"
+                << BLOCK_SOME << "' '" << BLOCK_MOST << "' '" << BLOCK_OPENED << "' opened, '" << BLOCK_HOLES << "' '"
+                << BLOCK_DENSE << "' black holes):\n";
+            for (auto row = top; row < top + block_rows; row++) {
+                std::cout << (covers(row, view.top, rows) ? '>' : ' ');
+                for (auto col = left; col < left + block_cols; col++) {
+                    std::cout << block_glyph(tiles.block(view.level, row, col));
+                }
+                std::cout << "\n";
+            }
+            std::cout << ' ';
+            for (auto col = left; col < left + block_cols; col++) {
+                std::cout << (covers(col, view.left, cols) ? '^' : ' ');
+            }
+            std::cout << std::endl;
+        }
+
+    } // namespace
+
     void showMessage(const char* msg) {
         std::cout << msg;
     }
@@ -77,17 +212,80 @@ namespace GameUI {
         std::cin >> black_holes;
     }
 
-    // Like a click anywhere, not necessarily on the board
-    bool getMoveInTheGame(int& row, int& col) {
+    // Like a click anywhere, not necessarily on the board. On a board larger than the viewport
+    // W, A, S, D pan the viewport by half of it, + and - zoom the overview in and out.
+    MoveInput getMoveInTheGame(int& row, int& col, const GameBoard* board, Viewport& view) {
         row = col = 0; // clear it
-        std::cout << "Enter your move (row column) or zero to cancel:";
+        const bool hints = GameSettings::getSettings().get_hints(),
+                   panning = !fits_viewport(board);
+        std::cout << "Enter your move (row column)" << (hints ? ", H for a hint" : "")
+            << (panning ? ", W A S D to pan, + - to zoom" : "") << " or zero to cancel:";
+        if (hints || panning) {
+            std::cin >> std::ws;
+            const int c = std::cin.peek();
+            if (hints && ('H' == c || 'h' == c)) {
+                std::cin.get();
+                return MoveInput::Hint;
+            }
+            if (panning && std::char_traits<char>::eof() != c && std::strchr("WwAaSsDd+-", c)) {
+                std::cin.get();
+                clamp_viewport(board, view);
+                switch (std::tolower(c)) {
+                case 'w': view.top -= VIEW_ROWS / 2; break;
+                case 's': view.top += VIEW_ROWS / 2; break;
+                case 'a': view.left -= VIEW_COLS / 2; break;
+                case 'd': view.left += VIEW_COLS / 2; break;
+                case '+': view.level = std::max(0, view.level - 1); break;
+                default:  view.level++; break;
+                }
+                return MoveInput::View;
+            }
+        }
         std::cin >> row >> col;
-        return (row && col); // > 0
+        return (row && col) ? MoveInput::Move : MoveInput::Cancel; // > 0
+    }
+
+    // Rows and columns are shown 1-based, like a player enters them
+    void showHint(const GameHint::Hint* hint) {
+        if (!hint) {
+            std::cout << "The hint is not ready yet, try again in a moment...\n";
+            return;
+        }
+        if (!hint->safe.empty()) {
+            std::cout << "Safe cells:";
+            for (const auto& cell : hint->safe) {
+                std::cout << " " << cell.first + 1 << " " << cell.second + 1 << ";";
+            }
+            std::cout << "\n";
+        }
+        if (!hint->holes.empty()) {
+            std::cout << "Black holes:";
+            for (const auto& cell : hint->holes) {
+                std::cout << " " << cell.first + 1 << " " << cell.second + 1 << ";";
+            }
+            std::cout << "\n";
+        }
+        if (hint->safe.empty() && hint->guess_row >= 0) {
+            std::cout << "No safe cells, the best guess is " << hint->guess_row + 1 << " " << hint->guess_col + 1
+                << " (a black hole with the probability about " << (int)(hint->guess_probability * 100 + 0.5) << "%";
+            if (hint->guess_error > 0) {
+                std::cout << " +/- " << (int)(hint->guess_error * 100 + 0.5) << "%";
+            }
+            std::cout << ")\n";
+        }
     }
 
 
-    void ShowGameBoard(const GameBoard* board, bool debug_mode) {
+    void ShowGameBoard(const GameBoard* board, bool debug_mode, Viewport& view) {
+        GAME_STATS_TIMER(ShowGameBoard);
         std::cout << "Game state " << (debug_mode ? "(debug mode)" : "") << ":\n";
+        if (!fits_viewport(board)) {
+            showViewport(board, debug_mode, view);
+            if (debug_mode && board->zero_regions() >= 0) {
+                std::cout << "Zero regions: " << board->zero_regions() << "\n";
+            }
+            return;
+        }
 
         int cnt = debug_mode ? 2 : 1;
         // header
@@ -109,9 +307,12 @@ namespace GameUI {
         std::cout << std::endl;
 
 
+        // The odd rows of a hex grid are shifted half a cell to the right (see HexTopology)
+        const bool hex = BoardTopology::Hex == board->topology();
         for (auto row = 0; row < board->board_size(); ++row) {
+            const bool shifted = hex && (row & 1);
             for (auto i = 0; i < cnt; i++) {
-                std::cout << std::setw(2) << row + 1 << "|";
+                std::cout << std::setw(2) << row + 1 << "|" << (shifted ? " " : "");
                 for (auto col = 0; col < board->board_size(); ++col) {
                     char cell = CELL_CLOSED;
                     auto nearBy = [](const GameBoard * board, int r, int c) { return '0' + board->black_holes_nearby(r, c); };
@@ -127,7 +328,7 @@ namespace GameUI {
 
                     std::cout << " " << cell << " ";
                 }
-                std::cout << "|";
+                std::cout << (hex && !shifted ? " |" : "|");
             }
             std::cout << std::endl;
         }
@@ -141,6 +342,9 @@ namespace GameUI {
         }
         std::cout << std::endl;
 
-    }// void ShowGameBoard(const GameBoard* board, bool debug_mode)
+        if (debug_mode && board->zero_regions() >= 0) {
+            std::cout << "Zero regions: " << board->zero_regions() << "\n";
+        }
+    }// void ShowGameBoard(const GameBoard* board, bool debug_mode, Viewport& view)
 
 }; // namespace GameUI
@@ -3,6 +3,10 @@
 
 class GameBoard;
 
+namespace GameHint {
+    struct Hint;
+}
+
 namespace GameUI {
 
     enum class GameMenu {
@@ -12,14 +16,30 @@ namespace GameUI {
         Quit
     };
 
+    enum class MoveInput {
+        Move,
+        Hint,
+        View, // the viewport has been panned or zoomed
+        Cancel
+    };
+
+    // The part of a board larger than VIEW_ROWS x VIEW_COLS that is shown cell by cell, and the level of the overview
+    // around it (see TileCounts): one character of the overview stands for 2^level x 2^level tiles
+    struct Viewport {
+        int top = 0;
+        int left = 0;
+        int level = -1; // -1 - the finest level that fits the whole board into the overview
+    };
+
     GameMenu gameMenu();
 
     void showMessage(const char* msg);
     void Welcome();
     void getBoardSize(int& sz, int min_val, int max_val);
     void getBlackHoles(int& black_holes, int min_val, int max_val);
-    bool getMoveInTheGame(int& row, int& col);
-    void ShowGameBoard(const GameBoard* board, bool debug_mode);
+    MoveInput getMoveInTheGame(int& row, int& col, const GameBoard* board, Viewport& view);
+    void showHint(const GameHint::Hint* hint);
+    void ShowGameBoard(const GameBoard* board, bool debug_mode, Viewport& view);
 };
 
 #endif
@@ -8,6 +8,8 @@
 #include <chrono>
 
 #include "Helpers.h"
+#include "GameData.h"
+#include "GameStats.h"
 
 // Integer square root (using binary search)
 static unsigned int isqrt(unsigned int y) {
@@ -18,7 +20,7 @@ static unsigned int isqrt(unsigned int y) {
     while (L != R - 1) {
         M = (L + R) / 2;
 
-        if (M * M <= y)
+        if ((unsigned long long)M * M <= y) // M * M overflows 32 bits on large boards
             L = M;
         else
             R = M;
@@ -42,6 +44,7 @@ static unsigned int isqrt(unsigned int y) {
 
 */
 std::vector<int> randoms(int count, int from, int to) {
+    GAME_STATS_TIMER(Randoms);
     assert(count > 0 && (to - from) > count);
     std::vector<int> result(count, 0);
     std::vector<int> rinds;
@@ -65,6 +68,55 @@ std::vector<int> randoms(int count, int from, int to) {
     return result;
 }
 
+/*
+
+ Function: shuffled_cells
+
+ Description: puts the cells 0..cells-1 in a random order by a partial Fisher-Yates shuffle:
+ only the first count cells are drawn, the rest keep the order the swaps left them in
+
+ Parameters:
+      cells - the number of cells of the board
+      count - the number of cells to draw (e.g. the black holes)
+      rgen - the random numbers
+
+ Returns: all the cells, the first count of them drawn at random
+
+*/
+std::vector<int> shuffled_cells(int cells, int count, std::mt19937_64& rgen) {
+    assert(0 <= count && count <= cells);
+    std::vector<int> result(cells);
+    for (auto i = 0; i < cells; i++) {
+        result[i] = i;
+    }
+    for (auto i = 0; i < count; i++) {
+        std::uniform_int_distribution<int> distr(i, cells - 1);
+        std::swap(result[i], result[distr(rgen)]);
+    }
+    return result;
+}
+
+/*
+
+ Function: seeded_black_holes
+
+ Description: draws the black holes of a reproducible board (see shuffled_cells)
+
+ Parameters:
+      cells - the number of cells of the board
+      count - the number of black holes
+      seed - the same seed gives the same black holes
+
+ Returns: vector of count distinct cells
+
+*/
+std::vector<int> seeded_black_holes(int cells, int count, uint64_t seed) {
+    std::mt19937_64 rgen(zobrist_mix(seed));
+    std::vector<int> result = shuffled_cells(cells, count, rgen);
+    result.resize(count);
+    return result;
+}
+
 /*
    Function: black_holes_from_file
 
@@ -90,6 +142,7 @@ std::vector<int> randoms(int count, int from, int to) {
 
 */
 std::vector<int> black_holes_from_file(const char* filename, unsigned int& n) {
+    GAME_STATS_TIMER(BlackHolesFromFile);
     std::ifstream ifs(filename);
 
     std::vector<int> v;
@@ -1,9 +1,13 @@
 #ifndef Helpers_h
 #define Helpers_h
 
+#include <cstdint>
+#include <random>
 #include <vector>
 
 std::vector<int> randoms(int count, int from, int to);
+std::vector<int> shuffled_cells(int cells, int count, std::mt19937_64& rgen);
+std::vector<int> seeded_black_holes(int cells, int count, uint64_t seed);
 std::vector<int> black_holes_from_file(const char* filename, unsigned int& n);
 
 #endif // Helpers_h
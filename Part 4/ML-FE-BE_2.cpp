@@ -3,25 +3,108 @@
 // - NxN board
 // - Location of black holes
 // - Counts of # of adjacent black 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
+#include "BoardPool.h"
+#include "GameAnalytics.h"
 #include "GameController.h"
+#include "GameData.h"
+#include "GameHint.h"
+#include "GameLoad.h"
+#include "GameScript.h"
+#include "GameStats.h"
+#include "GameSweep.h"
+#include "GameTelemetry.h"
+#include "GameTournament.h"
+#include "SharedBoard.h"
 
 
+// The end of every mode: the telemetry file is closed, then the statistics are reported if asked for
+static int finish(int result, bool stats, bool stats_json)
+{
+    GameTelemetry::stop();
+    if (stats) {
+        GameStats::report(std::cerr, stats_json, { GameHint::cache().counters("hint") });
+    }
+    return result;
+}
+
 static void usage(std::string name)
 {
     std::cerr << "Usage: " << name << " <option(s)>\n"
         << "Options:\n"
         << "\t-h,--help\t\tShow this help message\n"
         << "\t-d,--debug\t\tShow secondary debug game board\n"
-        << "\t-f,--file <filename>\tRead game settings from the specified file"
+        << "\t-f,--file <filename>\tRead game settings from the specified file\n"
+        << "\t-s,--script [filename]\tRun non-interactively: read commands from the file or stdin\n"
+        << "\t\t\t\tand print machine-readable results only\n"
+        << "\t--hints\t\t\tAllow to ask for a hint (H) instead of a move\n"
+        << "\t--tiled\t\t\tKeep boards larger than 16x16 in the tiled (Z-order) layout\n"
+        << "\t--save <filename>\tSave the game after every move and resume it when the game is started again\n"
+        << "\t--topology <name>\tThe neighbourhood of the cells: square (8 neighbours, by default),\n"
+        << "\t\t\t\tvon-neumann (4), hex (6) or torus (8, wrapping around the edges)\n"
+        << "\t-r,--regions\t\tPrecompute the zero regions of each new board, so reveals are lookups\n"
+        << "\t--sweep[=json] [filename]\tPlay games of all board sizes and numbers of black holes with hints,\n"
+        << "\t\t\t\twrite the win rates as CSV (or JSON) to the file or stdout\n"
+        << "\t--games <count>\t\tGames of each configuration of the sweep (" << SWEEP_GAMES << " by default)\n"
+        << "\t--checkpoint <filename>\tSave the progress of the sweep there and resume from it (sweep.checkpoint by default)\n"
+        << "\t--tournament[=json] [filename]\tPlay the same boards with every strategy on all threads,\n"
+        << "\t\t\t\twrite the paired win rates and decision times to the file or stdout\n"
+        << "\t--corpus <filename>\tThe boards of the tournament: a board file (as for -f) on each line\n"
+        << "\t--seeds <first> <count>\tOtherwise the random boards of the seeds (0 " << TOURNAMENT_SEEDS << " by default)\n"
+        << "\t--board <size> <holes>\tThe size and black holes of these boards (" << TOURNAMENT_BOARD_SIZE << " " << TOURNAMENT_BLACK_HOLES << " by default)\n"
+        << "\t--strategies <names>\tComma separated strategies of the tournament (all by default):\n"
+        << "\t\t\t\t" << TournamentStrategies() << "\n"
+        << "\t--analyze[=json] [filename]\tWrite the 3BV, openings and isolated cells of every board of --corpus\n"
+        << "\t\t\t\t(or of --seeds with --board) as CSV (or JSON) to the file or stdout\n"
+        << "\t--load[=json] [filename]\tRun simulated players against the engine on all threads and write\n"
+        << "\t\t\t\tthe latency percentiles of new games, moves and state queries (boards of --board)\n"
+        << "\t--players <count>\tSimulated players of the load (" << LOAD_PLAYERS << " by default)\n"
+        << "\t--rate <count>\t\tOperations per second of all players, 0 - as fast as possible (by default)\n"
+        << "\t--duration <seconds>\tLength of the load run (" << LOAD_SECONDS << " by default)\n"
+        << "\t--open-loop\t\tOperations arrive at the rate whether or not the earlier ones are done\n"
+        << "\t--spin <microseconds>\tSpin instead of sleeping this long before a paced operation (" << LOAD_SPIN_US << " by default)\n"
+        << "\t--telemetry[=jsonl] <filename>\tRecord the games, moves and their times of all threads into the file,\n"
+        << "\t\t\t\tas " << sizeof(TelemetryEvent) << "-byte records (or JSON lines), see GameTelemetry.h\n"
+        << "\t--telemetry-overflow <drop|block>\tWhen a thread records faster than the file is written,\n"
+        << "\t\t\t\tdrop and count its events (by default) or wait\n"
+        << "\t--shm [name]\t\tPlay with a bot in another process through the shared memory segment\n"
+        << "\t\t\t\t(" << SHARED_BOARD_NAME << " by default), see SharedBoard.h\n"
+        << "\t--stats[=json]\t\tPrint hot-path timers, counters and latency histograms at exit\n"
+        << "\t\t\t\t(requires a build with make STATS=1)"
         << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     bool debug = false;
     const char* filename = nullptr;
+    bool script = false;
+    const char* script_file = nullptr;
+    bool stats = false,
+         stats_json = false;
+    bool sweep = false,
+         sweep_json = false;
+    const char* sweep_file = nullptr;
+    const char* checkpoint = "sweep.checkpoint";
+    int games = SWEEP_GAMES;
+    const char* shared_name = nullptr;
+    bool tournament = false,
+         tournament_json = false;
+    const char* tournament_file = nullptr;
+    TournamentBoards tournament_boards;
+    bool analyze = false,
+         analyze_json = false;
+    const char* analyze_file = nullptr;
+    bool load = false,
+         load_json = false;
+    const char* load_file = nullptr;
+    LoadOptions load_options;
+    std::string strategies;
+    const char* telemetry_file = nullptr;
+    GameTelemetry::Format telemetry_format = GameTelemetry::Format::Binary;
+    GameTelemetry::Overflow telemetry_overflow = GameTelemetry::Overflow::Drop;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if ((arg == "-h") || (arg == "--help")) {
@@ -39,6 +122,189 @@ int main(int argc, char* argv[]) {
             }
             filename = argv[i + 1];
         }
+        else if ((arg == "-s") || (arg == "--script")) {
+            script = true;
+            if (argv[i + 1] && argv[i + 1][0] != '-') {
+                script_file = argv[++i];
+            }
+        }
+        else if (arg == "--hints") {
+            GameSettings::getSettings().set_hints(true);
+        }
+        else if (arg == "--tiled") {
+            GameSettings::getSettings().set_tiled_layout(true);
+        }
+        else if (arg == "--save") {
+            if (nullptr == argv[i + 1]) {
+                std::cerr << "Invalid command line syntax. Filename required.\n";
+                usage(argv[0]);
+                return 1;
+            }
+            GameSettings::getSettings().set_save_file(argv[++i]);
+        }
+        else if (arg == "--topology") {
+            const std::string name = argv[i + 1] ? argv[++i] : "";
+            if (name == "square" || name == "von-neumann" || name == "hex" || name == "torus") {
+                GameSettings::getSettings().set_topology(name == "von-neumann" ? BoardTopology::VonNeumann
+                                                       : name == "hex" ? BoardTopology::Hex
+                                                       : name == "torus" ? BoardTopology::Torus : BoardTopology::Square);
+            }
+            else {
+                std::cerr << "Invalid command line syntax. Topology required: square, von-neumann, hex or torus.\n";
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if ((arg == "-r") || (arg == "--regions")) {
+            GameSettings::getSettings().set_region_index(true);
+        }
+        else if ((arg == "--sweep") || (arg == "--sweep=json")) {
+            sweep = true;
+            sweep_json = (arg == "--sweep=json");
+            if (argv[i + 1] && argv[i + 1][0] != '-') {
+                sweep_file = argv[++i];
+            }
+        }
+        else if ((arg == "--games") || (arg == "--checkpoint")) {
+            if (nullptr == argv[i + 1]) {
+                std::cerr << "Invalid command line syntax. " << (arg == "--games" ? "Count" : "Filename") << " required.\n";
+                usage(argv[0]);
+                return 1;
+            }
+            if (arg == "--games") {
+                games = std::atoi(argv[++i]);
+            }
+            else {
+                checkpoint = argv[++i];
+            }
+        }
+        else if ((arg == "--tournament") || (arg == "--tournament=json")) {
+            tournament = true;
+            tournament_json = (arg == "--tournament=json");
+            if (argv[i + 1] && argv[i + 1][0] != '-') {
+                tournament_file = argv[++i];
+            }
+        }
+        else if ((arg == "--analyze") || (arg == "--analyze=json")) {
+            analyze = true;
+            analyze_json = (arg == "--analyze=json");
+            if (argv[i + 1] && argv[i + 1][0] != '-') {
+                analyze_file = argv[++i];
+            }
+        }
+        else if ((arg == "--corpus") || (arg == "--strategies")) {
+            if (nullptr == argv[i + 1]) {
+                std::cerr << "Invalid command line syntax. " << (arg == "--corpus" ? "Filename" : "Strategies") << " required.\n";
+                usage(argv[0]);
+                return 1;
+            }
+            (arg == "--corpus" ? tournament_boards.corpus : strategies) = argv[++i];
+        }
+        else if ((arg == "--seeds") || (arg == "--board")) {
+            if (nullptr == argv[i + 1] || nullptr == argv[i + 2]) {
+                std::cerr << "Invalid command line syntax. Two numbers required.\n";
+                usage(argv[0]);
+                return 1;
+            }
+            if (arg == "--seeds") {
+                tournament_boards.first_seed = (unsigned)std::strtoul(argv[i + 1], nullptr, 10);
+                tournament_boards.seeds = std::atoi(argv[i + 2]);
+            }
+            else {
+                tournament_boards.size = load_options.size = std::atoi(argv[i + 1]);
+                tournament_boards.black_holes = load_options.black_holes = std::atoi(argv[i + 2]);
+            }
+            i += 2;
+        }
+        else if ((arg == "--load") || (arg == "--load=json")) {
+            load = true;
+            load_json = (arg == "--load=json");
+            if (argv[i + 1] && argv[i + 1][0] != '-') {
+                load_file = argv[++i];
+            }
+        }
+        else if ((arg == "--players") || (arg == "--rate") || (arg == "--duration") || (arg == "--spin")) {
+            if (nullptr == argv[i + 1]) {
+                std::cerr << "Invalid command line syntax. " << (arg == "--players" ? "Count" : "Number") << " required.\n";
+                usage(argv[0]);
+                return 1;
+            }
+            const char* value = argv[++i];
+            if (arg == "--players") {
+                load_options.players = std::atoi(value);
+            }
+            else if (arg == "--rate") {
+                load_options.rate = std::atof(value);
+            }
+            else if (arg == "--spin") {
+                load_options.spin_us = std::atoi(value);
+            }
+            else {
+                load_options.seconds = std::atof(value);
+            }
+        }
+        else if (arg == "--open-loop") {
+            load_options.open_loop = true;
+        }
+        else if ((arg == "--telemetry") || (arg == "--telemetry=jsonl")) {
+            if (nullptr == argv[i + 1]) {
+                std::cerr << "Invalid command line syntax. Filename required.\n";
+                usage(argv[0]);
+                return 1;
+            }
+            telemetry_file = argv[++i];
+            telemetry_format = (arg == "--telemetry=jsonl") ? GameTelemetry::Format::Jsonl : GameTelemetry::Format::Binary;
+        }
+        else if (arg == "--telemetry-overflow") {
+            const std::string policy = argv[i + 1] ? argv[++i] : "";
+            if (policy == "drop" || policy == "block") {
+                telemetry_overflow = (policy == "block") ? GameTelemetry::Overflow::Block : GameTelemetry::Overflow::Drop;
+            }
+            else {
+                std::cerr << "Invalid command line syntax. Overflow policy required: drop or block.\n";
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--shm") {
+            shared_name = SHARED_BOARD_NAME;
+            if (argv[i + 1] && argv[i + 1][0] != '-') {
+                shared_name = argv[++i];
+            }
+        }
+        else if ((arg == "--stats") || (arg == "--stats=json")) {
+            stats = true;
+            stats_json = (arg == "--stats=json");
+        }
+    }
+
+    if (telemetry_file && !GameTelemetry::start(telemetry_file, telemetry_format, telemetry_overflow)) {
+        std::cerr << "Cannot create the telemetry file " << telemetry_file << "\n";
+        return 1;
+    }
+
+    if (sweep) {
+        return finish(RunSweep(sweep_file, sweep_json, games, checkpoint), stats, stats_json);
+    }
+
+    if (load) {
+        return finish(RunLoad(load_file, load_json, load_options), stats, stats_json);
+    }
+
+    if (analyze) {
+        return finish(RunAnalytics(analyze_file, analyze_json, tournament_boards), stats, stats_json);
+    }
+
+    if (tournament) {
+        return finish(RunTournament(tournament_file, tournament_json, tournament_boards, strategies), stats, stats_json);
+    }
+
+    if (BoardTopology::Square != GameSettings::getSettings().get_topology() && GameSettings::getSettings().get_hints()) {
+        std::cerr << "Hints are for the square topology only, they are off\n";
+        GameSettings::getSettings().set_hints(false);
     }
-    return Run(debug, filename);
+    BoardPool::start(); // Random boards are made in the background
+    int result = shared_name ? RunShared(shared_name, filename) : script ? RunScript(script_file) : Run(debug, filename);
+    BoardPool::stop();
+    return finish(result, stats, stats_json);
 }
\ No newline at end of file
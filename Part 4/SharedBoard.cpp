@@ -0,0 +1,193 @@
+//
+// SharedBoard.cpp
+//
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "SharedBoard.h"
+#include "GameController.h"
+#include "GameData.h"
+
+#define SHARED_IDLE_SPINS    1000 // polls of an empty ring before the game starts to sleep between them
+#define SHARED_IDLE_SLEEP_US 100
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int8_t>::is_always_lock_free,
+              "The atomics of the segment must be lock-free to be shared between processes");
+
+#ifdef _WIN32
+
+int RunShared(const char*, const char*) {
+    std::cerr << "The shared-memory board needs POSIX shared memory, which this platform does not have\n";
+    return 1;
+}
+
+#else
+
+namespace {
+
+    int8_t cell_value(const GameBoard& board, int row, int col) {
+        if (!board.is_opened_cell(row, col)) {
+            return SHARED_CELL_CLOSED;
+        }
+        return board.is_black_hole_cell(row, col) ? SHARED_CELL_HOLE : (int8_t)board.black_holes_nearby(row, col);
+    }
+
+    // Writes the position into the segment under the seqlock. A new game is written whole, a move is written
+    // from its delta (see BoardObserver): the cells it opened and the state, so a move costs the cells it changed only.
+    class Publisher : public BoardObserver {
+        SharedBoard* shared;
+        int          black_holes = 0;
+
+        void begin() {
+            const uint64_t sequence = shared->sequence.load(std::memory_order_relaxed);
+            shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void end() {
+            shared->sequence.store(shared->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        void write_state(const GameBoard& board, MoveResult result) {
+            shared->state.store((int32_t)(board.IsGameover() ? (board.IsWin() ? GameState::Win : GameState::Lost) : GameState::Play),
+                                std::memory_order_relaxed);
+            shared->black_holes.store(black_holes, std::memory_order_relaxed);
+            shared->hidden.store(board.hidden_cells(), std::memory_order_relaxed);
+            shared->result.store((int32_t)result, std::memory_order_relaxed);
+        }
+
+    public:
+        explicit Publisher(SharedBoard* shared) : shared(shared) {}
+
+        void publish_game(const GameBoard& board, int holes) {
+            const int n = board.board_size();
+            black_holes = holes;
+            begin();
+            shared->game.fetch_add(1, std::memory_order_relaxed);
+            for (auto row = 0; row < n; row++) {
+                for (auto col = 0; col < n; col++) {
+                    shared->cells()[row * n + col].store(cell_value(board, row, col), std::memory_order_relaxed);
+                }
+            }
+            write_state(board, MoveResult::Opened);
+            end();
+        }
+
+        void on_move(const GameBoard& board, const BoardDelta& delta) override {
+            const int n = board.board_size();
+            begin();
+            for (auto i = 0; i < delta.opened_count; i++) {
+                const int cell = delta.opened[i];
+                shared->cells()[cell].store((int8_t)board.black_holes_nearby(cell / n, cell % n), std::memory_order_relaxed);
+            }
+            for (auto i = 0; i < delta.hole_count; i++) {
+                shared->cells()[delta.holes[i]].store(SHARED_CELL_HOLE, std::memory_order_relaxed);
+            }
+            write_state(board, GameState::Win == delta.after ? MoveResult::Win
+                             : GameState::Lost == delta.after ? MoveResult::Lost : MoveResult::Opened);
+            end();
+        }
+
+        // A move that has changed nothing, e.g. into a cell opened already
+        void publish_result(MoveResult result) {
+            begin();
+            shared->result.store((int32_t)result, std::memory_order_relaxed);
+            end();
+        }
+    };
+
+} // namespace
+
+/*
+    Function: RunShared
+    Parameters:
+        name - the name of the shared-memory segment, e.g. SHARED_BOARD_NAME
+        filename - the board of the first game, or nullptr for a random board
+
+    Description: creates the segment for the board size of the first game and publishes its position.
+    Then takes the moves of the bot from the ring: every move is applied and what it changed is published.
+    While the ring is empty the game polls it, after SHARED_IDLE_SPINS polls it sleeps between them.
+    The segment is removed when the bot sends Quit.
+
+    Returns: 0 on success, 1 if the segment cannot be created or the file has no valid board
+*/
+int RunShared(const char* name, const char* filename) {
+    auto game_board = NewGame(filename);
+    if (!game_board) {
+        std::cerr << "Cannot read the board from " << filename << "\n";
+        return 1;
+    }
+    const int n = game_board->board_size();
+    const uint64_t size = SharedBoard::size_for(n);
+
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        std::cerr << "Cannot create the shared memory " << name << "\n";
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(name);
+        }
+        return 1;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == memory) {
+        std::cerr << "Cannot map the shared memory " << name << "\n";
+        shm_unlink(name);
+        return 1;
+    }
+
+    SharedBoard* shared = new (memory) SharedBoard();
+    shared->n = n;
+    shared->size = size;
+    shared->version = SHARED_BOARD_VERSION;
+    Publisher publisher(shared);
+    publisher.publish_game(*game_board, GameSettings::getSettings().get_black_holes());
+    game_board->subscribe(&publisher);
+    shared->magic.store(SHARED_BOARD_MAGIC, std::memory_order_release); // The bot may attach now
+    std::cerr << "The board is shared as " << name << ", " << size << " bytes\n";
+
+    int idle = 0;
+    for (;;) {
+        SharedMove move;
+        if (!shared_board_pop(shared, move)) {
+            if (++idle > SHARED_IDLE_SPINS) {
+                std::this_thread::sleep_for(std::chrono::microseconds(SHARED_IDLE_SLEEP_US));
+            }
+            continue;
+        }
+        idle = 0;
+        shared->moves.fetch_add(1, std::memory_order_relaxed);
+        if (SharedCommand::Quit == move.command) {
+            break;
+        }
+        if (SharedCommand::NewGame == move.command) {
+            auto next = NewGame(filename);
+            if (next && next->board_size() == n) { // The segment is sized for n
+                game_board = std::move(next);
+                game_board->subscribe(&publisher);
+            }
+            publisher.publish_game(*game_board, GameSettings::getSettings().get_black_holes());
+            continue;
+        }
+        // A move that changes the board is published by the publisher as an observer of the board
+        const MoveResult result = game_board->IsGameover() ? MoveResult::Invalid : DoMove(*game_board, move.row, move.col);
+        if (MoveResult::Invalid == result || MoveResult::AlreadyOpened == result) {
+            publisher.publish_result(result);
+        }
+    }
+    game_board->unsubscribe(&publisher);
+
+    munmap(memory, size);
+    shm_unlink(name);
+    return 0;
+}
+
+#endif // _WIN32
@@ -0,0 +1,121 @@
+#ifndef SharedBoard_h
+#define SharedBoard_h
+
+//
+// The visible board in a POSIX shared-memory segment, for bots running as other processes.
+// The game publishes the position under a seqlock: the sequence is odd while the game writes, a reader copies
+// the position and retries if the sequence was odd or has changed, so readers never block the game.
+// The bot sends its moves through a single-producer/single-consumer ring in the same segment.
+// Neither side makes a system call to exchange a position or a move.
+//
+// A bot maps the segment (shm_open + mmap of SharedBoard::size bytes), checks magic and version,
+// then calls shared_board_read and shared_board_push in its loop.
+//
+
+#include <atomic>
+#include <cstdint>
+
+#define SHARED_BOARD_NAME    "/proxx_board" // the segment by default
+#define SHARED_BOARD_MAGIC   0x50524F58u    // "PROX"
+#define SHARED_BOARD_VERSION 1
+#define SHARED_MOVE_SLOTS    256            // a power of 2
+
+// What a cell shows
+#define SHARED_CELL_CLOSED -1 // 0..8 - black holes nearby
+#define SHARED_CELL_HOLE    9
+
+enum class SharedCommand : int32_t {
+    Open,    // open the cell (row, col), zero-based
+    NewGame, // start a new game of the same size
+    Quit     // stop the game process
+};
+
+struct SharedMove {
+    SharedCommand command;
+    int32_t       row;
+    int32_t       col;
+};
+
+struct SharedBoard {
+    std::atomic<uint32_t> magic; // set last, once the segment is ready
+
+    // Written once, before the magic
+    uint32_t version;
+    int32_t  n;    // the board is n x n cells
+    uint64_t size; // bytes of the segment
+
+    // The position, under the seqlock
+    alignas(64) std::atomic<uint64_t> sequence; // odd while the game writes the position
+    std::atomic<int32_t>  state;       // 1 - play, 2 - win, 3 - lost, as GameState
+    std::atomic<int32_t>  black_holes;
+    std::atomic<int32_t>  hidden;      // closed cells that are not black holes
+    std::atomic<int32_t>  result;      // MoveResult of the last move
+    std::atomic<uint32_t> game;        // games started
+    std::atomic<uint32_t> moves;       // moves taken from the ring
+
+    // The move ring: the bot writes the head, the game writes the tail
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+    alignas(64) SharedMove            ring[SHARED_MOVE_SLOTS];
+
+    // n * n cells follow, row by row
+    std::atomic<int8_t>* cells() {
+        return reinterpret_cast<std::atomic<int8_t>*>(this + 1);
+    }
+    const std::atomic<int8_t>* cells() const {
+        return reinterpret_cast<const std::atomic<int8_t>*>(this + 1);
+    }
+
+    static uint64_t size_for(int n) {
+        return sizeof(SharedBoard) + (uint64_t)n * n;
+    }
+};
+
+// The bot side: queues the move, returns false if the ring is full
+inline bool shared_board_push(SharedBoard* board, const SharedMove& move) {
+    const uint32_t head = board->head.load(std::memory_order_relaxed);
+    if (head - board->tail.load(std::memory_order_acquire) == SHARED_MOVE_SLOTS) {
+        return false;
+    }
+    board->ring[head % SHARED_MOVE_SLOTS] = move;
+    board->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// The game side: takes the next move, returns false if there is none
+inline bool shared_board_pop(SharedBoard* board, SharedMove& move) {
+    const uint32_t tail = board->tail.load(std::memory_order_relaxed);
+    if (tail == board->head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    move = board->ring[tail % SHARED_MOVE_SLOTS];
+    board->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// The bot side: copies a consistent position, 'cells' receives n * n values.
+// Returns its sequence number, which grows with every change of the position.
+inline uint64_t shared_board_read(const SharedBoard* board, int8_t* cells, int32_t& state, int32_t& hidden) {
+    const int count = board->n * board->n;
+    for (;;) {
+        const uint64_t sequence = board->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+        state = board->state.load(std::memory_order_relaxed);
+        hidden = board->hidden.load(std::memory_order_relaxed);
+        for (int i = 0; i < count; i++) {
+            cells[i] = board->cells()[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (board->sequence.load(std::memory_order_relaxed) == sequence) {
+            return sequence;
+        }
+    }
+}
+
+// Plays the games with the moves of a bot through the segment 'name' until the bot sends Quit.
+// The first game is read from the file, if any, like with -f. Returns 0 on success, 1 if the segment cannot be created.
+int RunShared(const char* name, const char* filename);
+
+#endif // SharedBoard_h
@@ -0,0 +1,96 @@
+#ifndef TranspositionTable_h
+#define TranspositionTable_h
+
+//
+// Bounded cache of analysis results keyed on the Zobrist hash of the visible board.
+// The table is direct-mapped: a key has one slot and a new result replaces the one there,
+// so the memory never grows. The slots are guarded by striped locks, any thread may look up and store.
+//
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "GameStats.h"
+
+#define TRANSPOSITION_TABLE_SLOTS 4096
+#define TRANSPOSITION_TABLE_LOCKS 64
+
+template <class Value>
+class TranspositionTable {
+    struct Slot {
+        uint64_t key = 0;
+        bool     used = false;
+        Value    value;
+    };
+
+    std::vector<Slot>       slots;
+    std::vector<std::mutex> locks;
+    std::atomic<uint64_t>   hits{ 0 },
+                            misses{ 0 },
+                            stores{ 0 },
+                            replaced{ 0 };
+
+    size_t slot_of(uint64_t key) const {
+        return (size_t)(key % slots.size());
+    }
+
+    std::mutex& lock_of(size_t slot) {
+        return locks[slot % locks.size()];
+    }
+
+public:
+    explicit TranspositionTable(size_t capacity = TRANSPOSITION_TABLE_SLOTS) : slots(capacity ? capacity : 1), locks(TRANSPOSITION_TABLE_LOCKS) {}
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Copies the result cached for the key to 'value'. Returns false if there is none.
+    bool lookup(uint64_t key, Value& value) {
+        const size_t slot = slot_of(key);
+        {
+            std::lock_guard<std::mutex> guard(lock_of(slot));
+            if (slots[slot].used && slots[slot].key == key) {
+                value = slots[slot].value;
+                hits.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Caches the result for the key, replacing the result of another key in its slot
+    void store(uint64_t key, const Value& value) {
+        const size_t slot = slot_of(key);
+        std::lock_guard<std::mutex> guard(lock_of(slot));
+        if (slots[slot].used && slots[slot].key != key) {
+            replaced.fetch_add(1, std::memory_order_relaxed);
+        }
+        slots[slot].key = key;
+        slots[slot].used = true;
+        slots[slot].value = value;
+        stores.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (size_t slot = 0; slot < slots.size(); slot++) {
+            std::lock_guard<std::mutex> guard(lock_of(slot));
+            slots[slot] = Slot();
+        }
+        hits = misses = stores = replaced = 0;
+    }
+
+    size_t   capacity() const { return slots.size(); }
+    uint64_t hit_count() const { return hits.load(std::memory_order_relaxed); }
+    uint64_t miss_count() const { return misses.load(std::memory_order_relaxed); }
+    uint64_t store_count() const { return stores.load(std::memory_order_relaxed); }
+    uint64_t replace_count() const { return replaced.load(std::memory_order_relaxed); }
+
+    // For the report of the statistics, see GameStats::report
+    GameStats::CacheCounters counters(const char* name) const {
+        return { name, capacity(), hit_count(), miss_count(), store_count(), replace_count() };
+    }
+};
+
+#endif // TranspositionTable_h